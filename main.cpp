@@ -1,5 +1,8 @@
 #include <iostream>    // Para entrada/salida estándar (cout, cin)
 #include <string>      // Para manejo de strings y operaciones de texto
+#include <cstdio>      // Para FILE*/fwrite del diario de operaciones
+#include <cerrno>      // Para EINTR al escribir reportes con write()
+#include <cstddef>     // Para offsetof
 #include <cstring>     // Para funciones de C strings (strcmp, strcpy, strncpy)
 #include <limits>      // Para constantes de límites numéricos (numeric_limits)
 #include <climits>     // Para constantes de enteros (INT_MIN, INT_MAX)
@@ -7,6 +10,27 @@
 #include <fstream>     // Para manejo de archivos (ifstream, ofstream)
 #include <iomanip>     // Para manipulación de formato de salida (fixed, setprecision)
 #include <vector>      // Para el uso de vectores dinámicos en importación
+#include <algorithm>   // Para sort y lower_bound en los índices
+#include <cstdint>     // Para enteros de ancho fijo (uint64_t) del mapa de ocupación
+#include <cassert>     // Para el verificador de agregados en compilaciones de depuración
+#include <cmath>       // Para fabs en la verificación de agregados
+#include <string_view> // Para tokenizar el CSV sin copias
+#include <charconv>    // Para from_chars (conversión numérica sin excepciones)
+#include <thread>      // Para la importación CSV en paralelo
+#include <atomic>      // Para la pila de inspecciones sin bloqueos
+#include <mutex>       // Para el acceso concurrente al almacén
+#include <shared_mutex> // Para el candado lector/escritor del maestro
+#include <chrono>      // Para las marcas de tiempo de la bitácora de inspecciones
+#if defined(_MSC_VER)
+#include <intrin.h>    // Para popcount / bit scan en MSVC
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>  // Para mmap al restaurar snapshots binarios
+#include <sys/stat.h>  // Para fstat (tamaño del archivo)
+#include <fcntl.h>     // Para open
+#include <unistd.h>    // Para close y fsync
+#define ALPHATECH_MMAP 1
+#endif
 
 using namespace std;
 
@@ -21,7 +45,7 @@ utilizando estructuras de datos avanzadas y técnicas de programación en C++.
 CARACTERÍSTICAS PRINCIPALES:
 • Almacén como matriz 2D implementada como arreglo 1D para eficiencia de memoria
 • Sistema maestro dinámico para gestión automática de memoria de lotes
-• Pila LIFO para historial de inspecciones con funcionalidad de deshacer
+• Pila LIFO (anillo sin bloqueos) para historial de inspecciones con funcionalidad de deshacer
 • Validación robusta de todas las entradas del usuario
 • Sistema completo de backup y restauración de datos
 • Alertas automáticas para gestión proactiva del inventario
@@ -29,17 +53,21 @@ CARACTERÍSTICAS PRINCIPALES:
 
 ARQUITECTURA DEL SISTEMA:
 1. VALIDACIÓN: Funciones robustas para validar entradas numéricas y de texto
-2. ALMACÉN: Matriz bidimensional optimizada como arreglo unidimensional
+2. ALMACÉN: Matriz bidimensional como arreglo 1D (denso) o tabla hash de celdas (disperso)
 3. MAESTRO: Sistema dinámico de gestión de memoria para lotes de producción
 4. PILA: Estructura LIFO para control de inspecciones con historial
-5. PERSISTENCIA: Sistema de archivos para backup y restauración
-6. INTERFAZ: Menú interactivo con 19 opciones completas
+5. PERSISTENCIA: Snapshot binario + diario de operaciones (recuperación al iniciar)
+   y bitácora de inspecciones mapeada en memoria con tasas móviles por lote y componente
+6. INTERFAZ: Menú interactivo con 19 opciones completas, modo por lotes (--batch)
+   y modo de medición con salida JSON (--bench)
 
 COMPLEJIDAD ALGORÍTMICA:
-• Búsqueda por ID: O(n) donde n = capacidad del maestro
-• Búsqueda por nombre: O(f*c) donde f=filas, c=columnas
-• Inserción de lote: O(1) amortizado con redimensionamiento automático
-• Exportación/Importación: O(f*c) para recorrer todas las posiciones
+• Búsqueda por ID: O(1) esperado mediante índice hash idLote -> slot -> celda
+• Búsqueda por nombre: O(k) con k = coincidencias (nombres internados); prefijo en O(log n + k)
+• Inserción de lote: O(1) amortizado; el maestro crece por bloques sin mover lotes
+• Exportación/Importación: O(f*c) en modo denso; O(lotes log lotes) en modo disperso
+• Persistencia: O(1) por operación (diario); O(estado) solo al compactar
+• Importación de archivos grandes: análisis en paralelo (hasta 8 hilos) y combinación en orden
 
 ======================================================================================*/
 
@@ -112,6 +140,124 @@ bool confirmarAccion(const char* mensaje) {
     return (respuesta == 'S' || respuesta == 's');
 }
 
+/*======================================================================================
+INSTRUMENTACIÓN: CONTADORES E HISTOGRAMAS DE LATENCIA
+======================================================================================
+Se activa compilando con -DALPHATECH_METRICAS; sin esa bandera las macros METRICA_*
+no generan código y el binario queda igual que sin instrumentación.
+- Cada hilo acumula en su propia estructura (thread_local): el camino rápido no usa
+  atómicos ni bloqueos. Las estructuras se registran una vez en una lista global para
+  poder sumarlas al consultar
+- Histogramas log-lineales (estilo HDR): 8 sub-intervalos por potencia de 2, error
+  relativo <= 12,5 %, de 1 ns a 2^64 ns en 496 contadores
+- Las operaciones por lote (reserva, búsquedas, colocar, mover, remover, pila) cuentan
+  todas las llamadas pero miden el tiempo de 1 de cada MUESTREO_METRICAS; crecer,
+  importar, exportar y colocar en bloque se miden siempre
+======================================================================================*/
+// Operaciones medidas
+enum OperacionMetrica {
+    MET_MAESTRO_RESERVAR, MET_MAESTRO_CRECER, MET_BUSCAR_ID, MET_BUSCAR_NOMBRE,
+    MET_COLOCAR, MET_MOVER, MET_REMOVER, MET_IMPORTAR, MET_EXPORTAR, MET_COLOCAR_LOTES,
+    MET_PILA_PUSH, MET_PILA_POP, MET_TOTAL_OPERACIONES
+};
+
+// Contadores sin tiempo
+enum ContadorMetrica {
+    CNT_CRECER_BYTES_COPIADOS,   // Bytes copiados por maestroGrow (tabla de bloques)
+    CNT_CRECER_BYTES_RESERVADOS, // Bytes de bloques nuevos
+    CNT_TOTAL_CONTADORES
+};
+
+#ifdef ALPHATECH_METRICAS
+const int CUBETAS_METRICAS = 496;
+const unsigned MUESTREO_METRICAS = 64;   // Potencia de 2
+
+const char* const NOMBRES_METRICAS[MET_TOTAL_OPERACIONES] = {
+    "maestro_reservar", "maestro_crecer", "buscar_id", "buscar_nombre",
+    "colocar", "mover", "remover", "importar", "exportar", "colocar_lotes",
+    "pila_push", "pila_pop"
+};
+const bool METRICA_MUESTREADA[MET_TOTAL_OPERACIONES] = {
+    true, false, true, true,
+    true, true, true, false, false, false,
+    true, true
+};
+const char* const NOMBRES_CONTADORES[CNT_TOTAL_CONTADORES] = {
+    "maestro_crecer_bytes_copiados", "maestro_crecer_bytes_reservados"
+};
+
+struct HistogramaLatencia {
+    unsigned long long llamadas;   // Todas las llamadas
+    unsigned long long muestras;   // Llamadas con tiempo medido
+    unsigned long long sumaNs;
+    unsigned long long maxNs;
+    unsigned long long cubetas[CUBETAS_METRICAS];
+};
+
+struct MetricasHilo {
+    HistogramaLatencia ops[MET_TOTAL_OPERACIONES];
+    unsigned long long contadores[CNT_TOTAL_CONTADORES];
+};
+
+inline int bitMasAlto(uint64_t x);
+
+// Lista global de las métricas de cada hilo (solo se bloquea al registrar y al leer)
+// Las estructuras no se liberan: quedan disponibles aunque el hilo termine
+mutex metricasMutex;
+vector<MetricasHilo*> metricasHilos;
+
+inline MetricasHilo& metricasHilo() {
+    thread_local MetricasHilo* propia = nullptr;
+    if (!propia) {
+        propia = new MetricasHilo();
+        lock_guard<mutex> guarda(metricasMutex);
+        metricasHilos.push_back(propia);
+    }
+    return *propia;
+}
+
+// Cubeta de un valor: exacta hasta 7, luego 8 sub-intervalos por potencia de 2
+inline int cubetaLatencia(uint64_t ns) {
+    if (ns < 8) return (int)ns;
+    int e = bitMasAlto(ns);
+    return 8 + (e - 3) * 8 + (int)((ns >> (e - 3)) & 7);
+}
+
+// Límite inferior de una cubeta (inversa de cubetaLatencia)
+inline uint64_t inicioCubeta(int b) {
+    if (b < 8) return (uint64_t)b;
+    int e = (b - 8) / 8 + 3;
+    return (uint64_t)(8 + (b - 8) % 8) << (e - 3);
+}
+
+// Mide el tiempo de su ámbito y lo registra al destruirse
+struct MedidorTiempo {
+    HistogramaLatencia* h;   // nullptr si esta llamada no se mide
+    chrono::steady_clock::time_point t0;
+    
+    explicit MedidorTiempo(OperacionMetrica op) {
+        HistogramaLatencia& hist = metricasHilo().ops[op];
+        hist.llamadas++;
+        h = (!METRICA_MUESTREADA[op] || (hist.llamadas & (MUESTREO_METRICAS - 1)) == 0) ? &hist : nullptr;
+        if (h) t0 = chrono::steady_clock::now();
+    }
+    ~MedidorTiempo() {
+        if (!h) return;
+        uint64_t ns = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+        h->muestras++;
+        h->sumaNs += ns;
+        h->maxNs = max(h->maxNs, (unsigned long long)ns);
+        h->cubetas[cubetaLatencia(ns)]++;
+    }
+};
+
+#define METRICA_TIEMPO(op) MedidorTiempo medidorMetrica(op)
+#define METRICA_CONTAR(contador, n) (metricasHilo().contadores[contador] += (n))
+#else
+#define METRICA_TIEMPO(op) ((void)0)
+#define METRICA_CONTAR(contador, n) ((void)0)
+#endif
+
 /*======================================================================================
 SISTEMA DE GESTIÓN DE ALMACÉN - FÁBRICA ALPHATECH
 ======================================================================================*/
@@ -124,96 +270,645 @@ typedef struct{
     int cantidadTotal;
 } LoteProduccion; //Definimos un nombre para el struct
 
+// Escritura y lectura de un campo que otros hilos leen sin candado (ver ACCESO
+// CONCURRENTE): el escritor publica con release y el lector lee con acquire, así un
+// lector que valida con un contador de versión no necesita barreras sueltas. En x86 son
+// movimientos comunes; solo impiden que el compilador reordene o parta el acceso
+template <typename T, typename V>
+inline void publicar(T& campo, V valor) {
+    T v = static_cast<T>(valor);
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store(&campo, &v, __ATOMIC_RELEASE);
+#else
+    *(volatile T*)&campo = v;
+#endif
+}
+
+template <typename T>
+inline T leerPublicado(const T& campo) {
+#if defined(__GNUC__) || defined(__clang__)
+    T v;
+    __atomic_load(&campo, &v, __ATOMIC_ACQUIRE);
+    return v;
+#else
+    return *(const volatile T*)&campo;
+#endif
+}
+
+/*======================================================================================
+ÍNDICE HASH idLote -> SLOT DEL MAESTRO
+======================================================================================
+Tabla de direccionamiento abierto con sondeo lineal. Cada entrada guarda el ID y el
+slot del maestro; la celda del almacén se obtiene del slot (ver Maestro::celda).
+- Factor de carga máximo 1/2: la tabla se duplica antes de superarlo
+- Eliminación por desplazamiento hacia atrás (sin lápidas), así las búsquedas no se degradan
+======================================================================================*/
+const int ID_VACIO = INT_MIN;  // Marca de entrada libre en la tabla
+
+struct IndiceID {
+    int* claves;  // IDs de lote (ID_VACIO = entrada libre)
+    int* slots;   // Slot del maestro asociado a cada ID
+    int cap;      // Capacidad de la tabla (potencia de 2)
+    int size;     // Entradas ocupadas
+};
+
+// Posición inicial de un ID en una tabla de capacidad cap (hash multiplicativo de Fibonacci)
+inline int indiceHash(int cap, int id) {
+    return (int)(((unsigned)id * 2654435769u) & (unsigned)(cap - 1));
+}
+
+inline int indiceHash(const IndiceID& ix, int id) {
+    return indiceHash(ix.cap, id);
+}
+
+// Inicializa la tabla vacía (cap debe ser potencia de 2)
+void indiceInit(IndiceID& ix, int cap = 16) {
+    ix.claves = new int[cap];
+    ix.slots = new int[cap];
+    for (int i = 0; i < cap; ++i) ix.claves[i] = ID_VACIO;
+    ix.cap = cap;
+    ix.size = 0;
+}
+
+// Libera la memoria de la tabla
+void indiceFree(IndiceID& ix) {
+    delete[] ix.claves;
+    delete[] ix.slots;
+    ix.claves = nullptr;
+    ix.slots = nullptr;
+    ix.cap = 0;
+    ix.size = 0;
+}
+
+// Busca el slot de un ID (-1 si no existe)
+// COMPLEJIDAD: O(1) esperado
+int indiceBuscar(const IndiceID& ix, int id) {
+    for (int i = indiceHash(ix, id); ix.claves[i] != ID_VACIO; i = (i + 1) & (ix.cap - 1)) {
+        if (ix.claves[i] == id) return ix.slots[i];
+    }
+    return -1;
+}
+
+void indiceInsertar(IndiceID& ix, int id, int slot);
+
+// Duplica la tabla y reinserta todas las entradas
+// La tabla nueva se arma aparte y se publica ya completa; con 'retirada' la vieja se
+// entrega ahí en lugar de liberarse (un lector sin candado puede estar recorriéndola)
+void indiceGrow(IndiceID& ix, IndiceID* retirada = nullptr) {
+    IndiceID nueva;
+    indiceInit(nueva, ix.cap * 2);
+    for (int i = 0; i < ix.cap; ++i) {
+        if (ix.claves[i] != ID_VACIO) indiceInsertar(nueva, ix.claves[i], ix.slots[i]);
+    }
+    if (retirada) {
+        *retirada = ix;
+    } else {
+        delete[] ix.claves;
+        delete[] ix.slots;
+    }
+    // La capacidad va última: quien la lea nueva ve también los arreglos nuevos
+    publicar(ix.slots, nueva.slots);
+    publicar(ix.claves, nueva.claves);
+    publicar(ix.cap, nueva.cap);
+    ix.size = nueva.size;
+}
+
+// Inserta (o actualiza) la asociación ID -> slot
+// COMPLEJIDAD: O(1) amortizado
+void indiceInsertar(IndiceID& ix, int id, int slot) {
+    if ((ix.size + 1) * 2 > ix.cap) indiceGrow(ix);
+    
+    int i = indiceHash(ix, id);
+    while (ix.claves[i] != ID_VACIO && ix.claves[i] != id) i = (i + 1) & (ix.cap - 1);
+    if (ix.claves[i] == ID_VACIO) ix.size++;
+    publicar(ix.slots[i], slot);
+    publicar(ix.claves[i], id);
+}
+
+// Elimina un ID de la tabla (desplazamiento hacia atrás para cerrar el hueco)
+bool indiceEliminar(IndiceID& ix, int id) {
+    int mask = ix.cap - 1;
+    int i = indiceHash(ix, id);
+    while (ix.claves[i] != id) {
+        if (ix.claves[i] == ID_VACIO) return false;
+        i = (i + 1) & mask;
+    }
+    
+    // Recorrer el grupo siguiente y mover hacia el hueco las entradas que lo necesiten
+    int hueco = i;
+    for (int j = (i + 1) & mask; ix.claves[j] != ID_VACIO; j = (j + 1) & mask) {
+        int ideal = indiceHash(ix, ix.claves[j]);
+        // La entrada j puede ocupar el hueco si su posición ideal no está en (hueco, j]
+        if (((j - ideal) & mask) >= ((j - hueco) & mask)) {
+            publicar(ix.slots[hueco], ix.slots[j]);
+            publicar(ix.claves[hueco], ix.claves[j]);
+            hueco = j;
+        }
+    }
+    publicar(ix.claves[hueco], ID_VACIO);
+    ix.size--;
+    return true;
+}
+
+/*======================================================================================
+TABLA DE NOMBRES INTERNADOS (COMPONENTES)
+======================================================================================
+Cada nombre de componente distinto se guarda una sola vez y recibe un ID pequeño.
+- Hash nombre -> nombreId (direccionamiento abierto) para búsquedas exactas O(1)
+- Arreglo de nombreIds ordenado alfabéticamente para búsquedas por prefijo; los nombres
+  nuevos se agregan al final y se ordenan y mezclan en la siguiente búsqueda por prefijo
+- Por cada nombre, cabeza de la lista (intrusiva en el maestro) de slots con ese nombre
+Los nombres nunca se eliminan: un nombre sin lotes simplemente queda con cuenta 0.
+======================================================================================*/
+const int NOMBRE_MAX = 50;  // Igual que LoteProduccion::nombreComponente
+
+struct TablaNombres {
+    char* nombres;   // Nombres internados (NOMBRE_MAX bytes cada uno)
+    int* primero;    // Primer slot del maestro con ese nombre (-1 si ninguno)
+    int* cuenta;     // Lotes activos con ese nombre
+    int* orden;      // nombreIds ordenados alfabéticamente (hasta 'ordenados')
+    int ordenados;   // Prefijo de 'orden' ya ordenado; el resto está en orden de alta
+    int n;           // Nombres internados
+    int cap;         // Capacidad de los arreglos anteriores
+    int* hash;       // Tabla hash de nombreIds (-1 = libre)
+    int hashCap;     // Capacidad de la tabla hash (potencia de 2)
+};
+
+// Acceso al texto de un nombre internado
+inline const char* nombreTexto(const TablaNombres& t, int nid) {
+    return t.nombres + (size_t)nid * NOMBRE_MAX;
+}
+
+// Hash FNV-1a de una cadena
+inline unsigned nombreHash(const char* s) {
+    unsigned h = 2166136261u;
+    while (*s) { h ^= (unsigned char)*s++; h *= 16777619u; }
+    return h;
+}
+
+// Inicializa la tabla vacía
+void nombresInit(TablaNombres& t) {
+    t.cap = 16;
+    t.n = t.ordenados = 0;
+    t.nombres = new char[(size_t)t.cap * NOMBRE_MAX];
+    t.primero = new int[t.cap];
+    t.cuenta = new int[t.cap];
+    t.orden = new int[t.cap];
+    t.hashCap = 32;
+    t.hash = new int[t.hashCap];
+    for (int i = 0; i < t.hashCap; ++i) t.hash[i] = -1;
+}
+
+// Libera la memoria de la tabla
+void nombresFree(TablaNombres& t) {
+    delete[] t.nombres;
+    delete[] t.primero;
+    delete[] t.cuenta;
+    delete[] t.orden;
+    delete[] t.hash;
+    t.nombres = nullptr;
+    t.primero = t.cuenta = t.orden = t.hash = nullptr;
+    t.n = t.ordenados = t.cap = t.hashCap = 0;
+}
+
+// Busca el nombreId de un nombre (-1 si no está internado)
+// COMPLEJIDAD: O(1) esperado
+int nombresBuscar(const TablaNombres& t, const char* nombre) {
+    METRICA_TIEMPO(MET_BUSCAR_NOMBRE);
+    int mask = t.hashCap - 1;
+    for (int i = nombreHash(nombre) & mask; t.hash[i] != -1; i = (i + 1) & mask) {
+        if (strcmp(nombreTexto(t, t.hash[i]), nombre) == 0) return t.hash[i];
+    }
+    return -1;
+}
+
+// Inserta un nombreId en la tabla hash (sin verificar duplicados)
+void nombresHashInsertar(TablaNombres& t, int nid) {
+    int mask = t.hashCap - 1;
+    int i = nombreHash(nombreTexto(t, nid)) & mask;
+    while (t.hash[i] != -1) i = (i + 1) & mask;
+    t.hash[i] = nid;
+}
+
+// Duplica los arreglos por nombre (texto, listas, cuentas y orden)
+void nombresGrow(TablaNombres& t) {
+    int nuevaCap = t.cap * 2;
+    char* nn = new char[(size_t)nuevaCap * NOMBRE_MAX];
+    int* np = new int[nuevaCap];
+    int* nc = new int[nuevaCap];
+    int* no = new int[nuevaCap];
+    memcpy(nn, t.nombres, (size_t)t.n * NOMBRE_MAX);
+    for (int i = 0; i < t.n; ++i) {
+        np[i] = t.primero[i];
+        nc[i] = t.cuenta[i];
+        no[i] = t.orden[i];
+    }
+    delete[] t.nombres; delete[] t.primero; delete[] t.cuenta; delete[] t.orden;
+    t.nombres = nn; t.primero = np; t.cuenta = nc; t.orden = no;
+    t.cap = nuevaCap;
+}
+
+// Devuelve el nombreId de un nombre, internándolo si es nuevo
+// COMPLEJIDAD: O(1) esperado (amortizado al crecer); el orden alfabético se difiere a
+// nombresOrdenar
+int nombresInternar(TablaNombres& t, const char* nombre) {
+    int nid = nombresBuscar(t, nombre);
+    if (nid != -1) return nid;
+    
+    // Paso 1: Agregar el texto y su lista vacía
+    if (t.n == t.cap) nombresGrow(t);
+    nid = t.n++;
+    char* destino = t.nombres + (size_t)nid * NOMBRE_MAX;
+    strncpy(destino, nombre, NOMBRE_MAX - 1);
+    destino[NOMBRE_MAX - 1] = '\0';
+    t.primero[nid] = -1;
+    t.cuenta[nid] = 0;
+    
+    // Paso 2: Registrar en la tabla hash (duplicándola si supera carga 1/2)
+    if (t.n * 2 > t.hashCap) {
+        delete[] t.hash;
+        t.hashCap *= 2;
+        t.hash = new int[t.hashCap];
+        for (int i = 0; i < t.hashCap; ++i) t.hash[i] = -1;
+        for (int i = 0; i < t.n; ++i) nombresHashInsertar(t, i);
+    } else {
+        nombresHashInsertar(t, nid);
+    }
+    
+    // Paso 3: Agregar al final del orden (se ordena en la próxima búsqueda por prefijo)
+    t.orden[nid] = nid;
+    return nid;
+}
+
+// Ordena los nombres agregados desde la última búsqueda por prefijo y los mezcla con
+// los ya ordenados
+// COMPLEJIDAD: O(k log k + nombres) con k nombres nuevos; O(1) si no hay nuevos
+void nombresOrdenar(TablaNombres& t) {
+    if (t.ordenados == t.n) return;
+    auto menor = [&t](int a, int b) { return strcmp(nombreTexto(t, a), nombreTexto(t, b)) < 0; };
+    sort(t.orden + t.ordenados, t.orden + t.n, menor);
+    inplace_merge(t.orden, t.orden + t.ordenados, t.orden + t.n, menor);
+    t.ordenados = t.n;
+}
+
+// Interna un campo de nombre de NOMBRE_MAX bytes (no necesariamente terminado en '\0'),
+// recortado a NOMBRE_MAX - 1 caracteres como en LoteProduccion
+int nombresInternarCampo(TablaNombres& t, const char* campo) {
+    char nombre[NOMBRE_MAX];
+    strncpy(nombre, campo, NOMBRE_MAX - 1);
+    nombre[NOMBRE_MAX - 1] = '\0';
+    return nombresInternar(t, nombre);
+}
+
 /*======================================================================================
 ESTRUCTURA MAESTRO - GESTIÓN DINÁMICA DE LOTES
+======================================================================================
+Los lotes se guardan en bloques de tamaño fijo (slab). Crecer solo agrega un bloque
+nuevo: los lotes existentes NUNCA se mueven y no hay que copiar toda la capacidad en
+cada expansión. El almacén guarda el slot de cada lote, no un puntero.
+- Índice de slot i -> bloque (i >> MAESTRO_BLOQUE_BITS), posición (i & (MAESTRO_BLOQUE-1))
+- Dentro de cada bloque los campos van en vectores paralelos (estructura de arreglos):
+  idLote, cantidadTotal y pesoUnitario son columnas contiguas de 4 bytes, así los
+  recorridos que solo miran uno o dos campos (stock bajo, pesos, IDs) leen 4-8 bytes
+  por lote en lugar de los 64 de un LoteProduccion completo.
+- El nombre no se guarda por slot: el slot guarda su nombreId y el texto vive una sola
+  vez en la tabla de nombres (maestroNombre), así un slot ocupa 29 bytes en lugar de
+  79 y crecer no reserva 50 bytes de texto por slot.
+- LoteProduccion queda como registro de intercambio (snapshots, diario); se arma con
+  maestroLeerLote y se reparte en las columnas con maestroEscribirLote.
+- LoteCompacto es la variante en memoria de 16 bytes (el nombre como nombreId): caben
+  4 por línea de caché. loteCompactar y loteExpandir convierten entre ambos registros.
+- Los slots libres forman una lista enlazada intrusiva: en un slot libre la columna
+  idLote guarda el índice del siguiente slot libre, cantidadTotal vale CANTIDAD_LIBRE y
+  celda vale -1, así los filtros por cantidad y las sumas de lotes colocados descartan
+  los slots libres sin consultar 'used'. Reservar y liberar son O(1) y el último
+  slot liberado es el primero en reutilizarse (todavía caliente en caché).
+- Cada slot guarda además la celda del almacén donde está colocado (f*columnas+c, -1 si
+  no está colocado); junto con el índice hash, buscar un lote por ID cuesta O(1).
+- Cada slot guarda el nombreId de su componente y los enlaces de la lista de slots con
+  ese mismo nombre, así buscar por componente cuesta O(coincidencias).
 ======================================================================================*/
+const int MAESTRO_BLOQUE_BITS = 10;
+const int MAESTRO_BLOQUE = 1 << MAESTRO_BLOQUE_BITS;  // Lotes por bloque (1024)
+const int CANTIDAD_LIBRE = INT_MAX;                   // cantidadTotal de un slot libre
+
+struct BloqueMaestro {
+    // Columnas calientes (las recorren los escaneos)
+    int idLote[MAESTRO_BLOQUE];            // ID del lote (siguiente libre si no está usado)
+    int cantidadTotal[MAESTRO_BLOQUE];     // Unidades del lote
+    float pesoUnitario[MAESTRO_BLOQUE];    // Peso por unidad
+    bool used[MAESTRO_BLOQUE];             // Marcadores de slots usados
+    int celda[MAESTRO_BLOQUE];             // Celda del almacén (-1 = sin colocar)
+    int nombreId[MAESTRO_BLOQUE];          // Nombre internado del componente
+    int sigNombre[MAESTRO_BLOQUE];         // Siguiente slot con el mismo nombre (-1)
+    int antNombre[MAESTRO_BLOQUE];         // Slot anterior con el mismo nombre (-1)
+};
+
 struct Maestro {
-    LoteProduccion* data;  // Arreglo dinámico de lotes
-    bool* used;            // Marcadores de slots usados
-    int size;              // Cantidad de lotes activos
-    int cap;               // Capacidad total del arreglo
+    BloqueMaestro** bloques;  // Tabla de punteros a bloques
+    int nBloques;             // Bloques asignados
+    int capBloques;           // Capacidad de la tabla de bloques
+    int size;                 // Cantidad de lotes activos
+    int cap;                  // Capacidad total (nBloques * MAESTRO_BLOQUE)
+    int libre;                // Cabeza de la lista de slots libres (-1 si no hay)
+    IndiceID indice;          // Índice hash idLote -> slot
+    TablaNombres nombres;     // Nombres internados y listas de slots por nombre
+    vector<BloqueMaestro**> tablasRetiradas;  // Tablas de bloques reemplazadas al crecer
 };
 
-// Inicializa el sistema maestro
-void maestroInit(Maestro& m, int capIni = 8) {
-    m.data = new LoteProduccion[capIni];
-    m.used = new bool[capIni];
-    for (int i = 0; i < capIni; ++i) m.used[i] = false;
-    m.size = 0;
-    m.cap = capIni;
+// Acceso a los campos del lote del slot i (O(1), sin importar en qué bloque esté)
+inline int& maestroId(const Maestro& m, int i) {
+    return m.bloques[i >> MAESTRO_BLOQUE_BITS]->idLote[i & (MAESTRO_BLOQUE - 1)];
 }
 
-// Libera la memoria del sistema maestro
-void maestroFree(Maestro& m) {
-    delete[] m.data;
-    delete[] m.used;
-    m.data = nullptr; 
-    m.used = nullptr;
-    m.size = 0; 
-    m.cap = 0;
+inline int& maestroCantidad(const Maestro& m, int i) {
+    return m.bloques[i >> MAESTRO_BLOQUE_BITS]->cantidadTotal[i & (MAESTRO_BLOQUE - 1)];
+}
+
+inline float& maestroPeso(const Maestro& m, int i) {
+    return m.bloques[i >> MAESTRO_BLOQUE_BITS]->pesoUnitario[i & (MAESTRO_BLOQUE - 1)];
+}
+
+// idLote del slot i sin el candado del maestro (lectores sin bloqueo: concFila). Solo es
+// válido si el lector confirma después que el slot seguía en su celda
+inline int maestroIdPublicado(const Maestro& m, int i) {
+    BloqueMaestro* const* bloques = leerPublicado(m.bloques);
+    const BloqueMaestro* b = leerPublicado(bloques[i >> MAESTRO_BLOQUE_BITS]);
+    return leerPublicado(b->idLote[i & (MAESTRO_BLOQUE - 1)]);
+}
+
+// Acceso al nombreId del slot i
+inline int& maestroNombreId(const Maestro& m, int i) {
+    return m.bloques[i >> MAESTRO_BLOQUE_BITS]->nombreId[i & (MAESTRO_BLOQUE - 1)];
+}
+
+// Nombre del componente del slot i (texto internado, compartido por los lotes del mismo
+// componente)
+inline const char* maestroNombre(const Maestro& m, int i) {
+    return nombreTexto(m.nombres, maestroNombreId(m, i));
+}
+
+// Arma el registro completo del slot i (para snapshots y el diario)
+inline LoteProduccion maestroLeerLote(const Maestro& m, int i) {
+    LoteProduccion lote;
+    lote.idLote = maestroId(m, i);
+    memcpy(lote.nombreComponente, maestroNombre(m, i), NOMBRE_MAX);
+    lote.pesoUnitario = maestroPeso(m, i);
+    lote.cantidadTotal = maestroCantidad(m, i);
+    return lote;
+}
+
+// Reparte los campos numéricos de un registro completo en las columnas del slot i
+// (el nombre se interna y enlaza con maestroEnlazarNombre)
+inline void maestroEscribirLote(Maestro& m, int i, const LoteProduccion& lote) {
+    maestroId(m, i) = lote.idLote;
+    maestroPeso(m, i) = lote.pesoUnitario;
+    maestroCantidad(m, i) = lote.cantidadTotal;
+}
+
+// Registro compacto de un lote: 16 bytes, 4 por línea de caché (el nombre como nombreId
+// de la tabla de nombres del maestro que lo generó)
+struct alignas(16) LoteCompacto {
+    int idLote;
+    int cantidadTotal;
+    float pesoUnitario;
+    int nombreId;
+};
+static_assert(sizeof(LoteCompacto) == 16, "LoteCompacto debe ocupar 16 bytes");
+
+// Convierte un registro de intercambio al compacto (interna el nombre si es nuevo)
+inline LoteCompacto loteCompactar(TablaNombres& t, const LoteProduccion& lote) {
+    LoteCompacto c;
+    c.idLote = lote.idLote;
+    c.cantidadTotal = lote.cantidadTotal;
+    c.pesoUnitario = lote.pesoUnitario;
+    c.nombreId = nombresInternarCampo(t, lote.nombreComponente);
+    return c;
+}
+
+// Convierte un registro compacto al de intercambio (copia el texto internado)
+inline LoteProduccion loteExpandir(const TablaNombres& t, const LoteCompacto& c) {
+    LoteProduccion lote;
+    lote.idLote = c.idLote;
+    memcpy(lote.nombreComponente, nombreTexto(t, c.nombreId), NOMBRE_MAX);
+    lote.pesoUnitario = c.pesoUnitario;
+    lote.cantidadTotal = c.cantidadTotal;
+    return lote;
+}
+
+// Arma el registro compacto del slot i (cuatro columnas, sin tocar texto)
+inline LoteCompacto maestroLeerCompacto(const Maestro& m, int i) {
+    LoteCompacto c;
+    c.idLote = maestroId(m, i);
+    c.cantidadTotal = maestroCantidad(m, i);
+    c.pesoUnitario = maestroPeso(m, i);
+    c.nombreId = maestroNombreId(m, i);
+    return c;
+}
+
+// Acceso al marcador de uso del slot i
+inline bool& maestroUsado(const Maestro& m, int i) {
+    return m.bloques[i >> MAESTRO_BLOQUE_BITS]->used[i & (MAESTRO_BLOQUE - 1)];
+}
+
+// Acceso a la celda del almacén del slot i
+inline int& maestroCelda(const Maestro& m, int i) {
+    return m.bloques[i >> MAESTRO_BLOQUE_BITS]->celda[i & (MAESTRO_BLOQUE - 1)];
+}
+
+// Lectura y escritura de la celda con acceso atómico relajado, para el acceso concurrente
+// (un hilo puede consultar la celda mientras otro mueve el lote; en x86 es un mov normal)
+inline int maestroCeldaLeer(const Maestro& m, int i) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(&maestroCelda(m, i), __ATOMIC_RELAXED);
+#else
+    return *(volatile int*)&maestroCelda(m, i);
+#endif
+}
+
+inline void maestroCeldaEscribir(const Maestro& m, int i, int celda) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&maestroCelda(m, i), celda, __ATOMIC_RELAXED);
+#else
+    *(volatile int*)&maestroCelda(m, i) = celda;
+#endif
+}
+
+// Acceso a los enlaces de la lista por nombre del slot i
+inline int& maestroSigNombre(const Maestro& m, int i) {
+    return m.bloques[i >> MAESTRO_BLOQUE_BITS]->sigNombre[i & (MAESTRO_BLOQUE - 1)];
 }
 
-// Expande la capacidad del sistema maestro cuando se llena
-// ALGORITMO: Duplica la capacidad actual y copia todos los elementos existentes
-// COMPLEJIDAD: O(n) donde n es la capacidad actual
+inline int& maestroAntNombre(const Maestro& m, int i) {
+    return m.bloques[i >> MAESTRO_BLOQUE_BITS]->antNombre[i & (MAESTRO_BLOQUE - 1)];
+}
+
+// Agrega un bloque nuevo al maestro
+// ALGORITMO: Solo la tabla de punteros se duplica cuando se llena; los lotes no se copian
+// COMPLEJIDAD: O(MAESTRO_BLOQUE) por bloque, independiente de la capacidad actual
 void maestroGrow(Maestro& m) {
-    // Paso 1: Calcular nueva capacidad (duplicar o inicializar en 8)
-    int newCap = (m.cap == 0 ? 8 : m.cap * 2);
-    
-    // Paso 2: Crear nuevos arreglos con mayor capacidad
-    LoteProduccion* nd = new LoteProduccion[newCap];  // Nuevo arreglo de datos
-    bool* nu = new bool[newCap];                      // Nuevo arreglo de flags
-    
-    // Paso 3: Copiar todos los elementos existentes a los nuevos arreglos
-    for (int i = 0; i < m.cap; ++i) { 
-        nd[i] = m.data[i]; // Copia el lote completo (struct copy)
-        nu[i] = m.used[i]; // Copia el flag de uso
+    METRICA_TIEMPO(MET_MAESTRO_CRECER);
+    // Paso 1: Duplicar la tabla de bloques si ya no hay espacio (copia solo punteros)
+    if (m.nBloques == m.capBloques) {
+        int nuevaCap = (m.capBloques == 0 ? 4 : m.capBloques * 2);
+        BloqueMaestro** nt = new BloqueMaestro*[nuevaCap];
+        METRICA_CONTAR(CNT_CRECER_BYTES_COPIADOS, m.nBloques * sizeof(BloqueMaestro*));
+        for (int i = 0; i < m.nBloques; ++i) nt[i] = m.bloques[i];
+        // La tabla vieja se libera en maestroFree: un lector sin candado (concFila) puede
+        // estar leyéndola (ocupa menos que la nueva, así el total no llega al doble)
+        if (m.bloques) m.tablasRetiradas.push_back(m.bloques);
+        publicar(m.bloques, nt);
+        m.capBloques = nuevaCap;
     }
     
-    // Paso 4: Inicializar las nuevas posiciones como no utilizadas
-    for (int i = m.cap; i < newCap; ++i) nu[i] = false;
+    // Paso 2: Crear el bloque nuevo y encadenar sus slots en la lista libre
+    // (en orden inverso para que el slot más bajo quede a la cabeza)
+    BloqueMaestro* b = new BloqueMaestro;
+    METRICA_CONTAR(CNT_CRECER_BYTES_RESERVADOS, sizeof(BloqueMaestro));
+    int base = m.nBloques * MAESTRO_BLOQUE;
+    for (int i = MAESTRO_BLOQUE - 1; i >= 0; --i) {
+        b->used[i] = false;
+        b->idLote[i] = m.libre;
+        b->cantidadTotal[i] = CANTIDAD_LIBRE;
+        b->pesoUnitario[i] = 0.0f;
+        b->celda[i] = -1;
+        m.libre = base + i;
+    }
     
-    // Paso 5: Liberar memoria antigua y actualizar punteros
-    delete[] m.data; 
-    delete[] m.used;
-    m.data = nd;     // Apuntar a los nuevos arreglos
-    m.used = nu; 
-    m.cap = newCap;  // Actualizar capacidad
+    // Paso 3: Registrar el bloque y actualizar capacidad
+    publicar(m.bloques[m.nBloques++], b);
+    m.cap = m.nBloques * MAESTRO_BLOQUE;
+}
+
+// Inicializa el sistema maestro (capIni se redondea a bloques completos)
+void maestroInit(Maestro& m, int capIni = 8) {
+    m.bloques = nullptr;
+    m.tablasRetiradas.clear();
+    m.nBloques = 0;
+    m.capBloques = 0;
+    m.size = 0;
+    m.cap = 0;
+    m.libre = -1;
+    indiceInit(m.indice);
+    nombresInit(m.nombres);
+    do {
+        maestroGrow(m);
+    } while (m.cap < capIni);
+}
+
+// Libera la memoria del sistema maestro
+void maestroFree(Maestro& m) {
+    for (int i = 0; i < m.nBloques; ++i) delete m.bloques[i];
+    delete[] m.bloques;
+    for (BloqueMaestro** tabla : m.tablasRetiradas) delete[] tabla;
+    m.tablasRetiradas.clear();
+    m.bloques = nullptr;
+    m.nBloques = 0;
+    m.capBloques = 0;
+    m.size = 0; 
+    m.cap = 0;
+    m.libre = -1;
+    indiceFree(m.indice);
+    nombresFree(m.nombres);
 }
 
 // Reserva un slot en el sistema maestro
+// COMPLEJIDAD: O(1) - toma la cabeza de la lista libre (crece solo si está vacía)
 int maestroReservar(Maestro& m) {
-    for (int i = 0; i < m.cap; ++i) {
-        if (!m.used[i]) { 
-            m.used[i] = true; 
-            m.size++; 
-            return i; 
-        }
-    }
-    int old = m.cap; 
-    maestroGrow(m);
-    m.used[old] = true; 
-    m.size++; 
-    return old;
+    METRICA_TIEMPO(MET_MAESTRO_RESERVAR);
+    if (m.libre == -1) maestroGrow(m);
+    int idx = m.libre;
+    m.libre = maestroId(m, idx);  // Siguiente slot libre
+    maestroUsado(m, idx) = true;
+    m.size++;
+    return idx;
+}
+
+// Devuelve un slot a la lista libre
+// COMPLEJIDAD: O(1)
+void maestroLiberar(Maestro& m, int idx) {
+    maestroUsado(m, idx) = false;
+    publicar(maestroId(m, idx), m.libre);
+    maestroCantidad(m, idx) = CANTIDAD_LIBRE;
+    maestroPeso(m, idx) = 0.0f;
+    maestroCelda(m, idx) = -1;
+    m.libre = idx;
+    m.size--;
+}
+
+// Asegura espacio para n lotes más sin crecer durante una carga masiva
+void maestroReservarCapacidad(Maestro& m, int n) {
+    while (m.cap - m.size < n) maestroGrow(m);
+    while (m.indice.cap < 2 * (m.size + n)) indiceGrow(m.indice);
+}
+
+// Enlaza el slot al inicio de la lista de su nombre (internándolo si es nuevo)
+// El nombre se recorta a NOMBRE_MAX - 1 caracteres
+void maestroEnlazarNombre(Maestro& m, int idx, const char* nombre) {
+    TablaNombres& t = m.nombres;
+    int nid = nombresInternarCampo(t, nombre);
+    maestroNombreId(m, idx) = nid;
+    maestroAntNombre(m, idx) = -1;
+    maestroSigNombre(m, idx) = t.primero[nid];
+    if (t.primero[nid] != -1) maestroAntNombre(m, t.primero[nid]) = idx;
+    t.primero[nid] = idx;
+    t.cuenta[nid]++;
 }
 
 // Crea un nuevo lote en el sistema maestro
-LoteProduccion* maestroCrear(Maestro& m, int id, const char* nombre, float peso, int cant) {
+// RETORNA: El slot del lote (-1 si el ID ya existe)
+int maestroCrear(Maestro& m, int id, const char* nombre, float peso, int cant) {
+    if (indiceBuscar(m.indice, id) != -1) return -1;
+    
     int idx = maestroReservar(m);
-    m.data[idx].idLote = id;
-    strncpy(m.data[idx].nombreComponente, nombre, sizeof(m.data[idx].nombreComponente)-1);
-    m.data[idx].nombreComponente[sizeof(m.data[idx].nombreComponente)-1] = '\0';
-    m.data[idx].pesoUnitario = peso;
-    m.data[idx].cantidadTotal = cant;
-    return &m.data[idx];
+    indiceInsertar(m.indice, id, idx);
+    maestroCelda(m, idx) = -1;  // Aún no colocado en el almacén
+    publicar(maestroId(m, idx), id);
+    maestroPeso(m, idx) = peso;
+    maestroCantidad(m, idx) = cant;
+    
+    maestroEnlazarNombre(m, idx, nombre);
+    return idx;
+}
+
+// Carga en bloque un arreglo de lotes en un maestro VACÍO (restauración de snapshots)
+// ALGORITMO: Reparte cada registro en las columnas de su slot y en la misma pasada
+// reconstruye el índice hash y las listas por nombre; al final rehace la lista libre.
+// El lote i queda en el slot i.
+// RETORNA: false si hay IDs duplicados (el maestro queda inconsistente y debe reiniciarse)
+bool maestroCargar(Maestro& m, const LoteProduccion* lotes, int n) {
+    // Paso 1: Reservar capacidad de una vez (bloques e índice)
+    maestroReservarCapacidad(m, n);
+    
+    // Paso 2: Columnas y metadatos por slot
+    for (int i = 0; i < n; ++i) {
+        LoteProduccion lote;
+        memcpy(&lote, lotes + i, sizeof(lote));  // El origen puede venir de un mapeo sin alinear
+        if (indiceBuscar(m.indice, lote.idLote) != -1) return false;
+        maestroEscribirLote(m, i, lote);
+        maestroUsado(m, i) = true;
+        maestroCelda(m, i) = -1;
+        indiceInsertar(m.indice, lote.idLote, i);
+        maestroEnlazarNombre(m, i, lote.nombreComponente);
+    }
+    m.size = n;
+    
+    // Paso 3: Rehacer la lista libre con los slots restantes
+    m.libre = -1;
+    for (int i = m.cap - 1; i >= n; --i) {
+        maestroId(m, i) = m.libre;
+        maestroCantidad(m, i) = CANTIDAD_LIBRE;
+        maestroCelda(m, i) = -1;
+        m.libre = i;
+    }
+    return true;
 }
 
 // Busca un lote por ID en el sistema maestro
+// COMPLEJIDAD: O(1) esperado mediante el índice hash
 int maestroBuscarID(const Maestro& m, int id) {
-    for (int i = 0; i < m.cap; ++i) {
-        if (m.used[i] && m.data[i].idLote == id) return i;
-    }
-    return -1;
+    METRICA_TIEMPO(MET_BUSCAR_ID);
+    return indiceBuscar(m.indice, id);
 }
 
 // Elimina un lote del sistema maestro
@@ -221,176 +916,1084 @@ bool maestroEliminar(Maestro& m, int id) {
     int idx = maestroBuscarID(m, id);
     if (idx == -1) return false;
     
-    m.used[idx] = false;
-    m.size--;
+    // Desenlazar el slot de la lista de su nombre
+    TablaNombres& t = m.nombres;
+    int nid = maestroNombreId(m, idx);
+    int ant = maestroAntNombre(m, idx), sig = maestroSigNombre(m, idx);
+    if (ant != -1) maestroSigNombre(m, ant) = sig;
+    else t.primero[nid] = sig;
+    if (sig != -1) maestroAntNombre(m, sig) = ant;
+    t.cuenta[nid]--;
+    
+    indiceEliminar(m.indice, id);
+    maestroLiberar(m, idx);
     return true;
 }
 
+// Marca todos los lotes como no colocados (al descartar el almacén)
+void maestroDesubicar(Maestro& m) {
+    for (int i = 0; i < m.cap; ++i) maestroCelda(m, i) = -1;
+}
+
 /*======================================================================================
-SISTEMA DE ALMACÉN - MATRIZ 2D COMO ARREGLO 1D
+KERNELS VECTORIALES SOBRE LAS COLUMNAS DEL MAESTRO
 ======================================================================================
-CONCEPTO CLAVE: MAPEO DE COORDENADAS 2D A ÍNDICE 1D
-- Una matriz de F filas y C columnas se almacena como un arreglo de tamaño F*C
-- Para acceder a la posición (fila, columna), usamos: índice = fila * columnas + columna
-- Ejemplo: En una matriz 3x4, la posición (1,2) se mapea al índice: 1*4+2 = 6
-
-VENTAJAS DE ESTA IMPLEMENTACIÓN:
-• Mayor eficiencia de memoria (sin punteros intermedios)
-• Mejor localidad de referencia (cache-friendly)
-• Acceso directo O(1) a cualquier posición
-• Fácil implementación de algoritmos de recorrido
-
-IMPORTANTE: Los punteros apuntan a lotes en el sistema maestro, no son copias
+Los recorridos completos del maestro (stock bajo, verificación de agregados) trabajan
+bloque por bloque sobre las columnas contiguas cantidadTotal, pesoUnitario y celda.
+Cada kernel tiene una versión escalar y versiones SSE2 y AVX2; la variante se elige una
+sola vez en tiempo de ejecución según la CPU, así el mismo binario corre en cualquier
+x86-64 (SSE2 es parte de la base) y en otras arquitecturas queda la escalar.
+- filtrarHasta: posiciones con cantidad <= umbral, compactadas en un arreglo. AVX2
+  compara 8 cantidades por instrucción y escribe las coincidencias con una permutación
+  sacada de una tabla de 256 entradas (una por máscara de 8 bits).
+- sumarColocados: lotes, unidades (int64) y peso (peso * cantidad en double) de los
+  slots con celda >= 0. Los slots libres y los no colocados tienen celda -1 y no suman.
+  Las variantes vectoriales acumulan en varios carriles, así el peso puede diferir de
+  la versión escalar en el último bit de redondeo.
 ======================================================================================*/
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ALPHATECH_SIMD_X86 1
+#endif
 
-// Crea "matriz" 1D de punteros (todas las celdas a nullptr)
-// PARÁMETROS: filas y columnas definen las dimensiones del almacén
-// RETORNA: Puntero al arreglo de punteros (matriz simulada)
-LoteProduccion** crearAlmacen(int filas, int columnas) {
-    int N = filas * columnas;  // Calcular tamaño total necesario
-    LoteProduccion** A = new LoteProduccion*[N];  // Crear arreglo de punteros
-    
-    // Inicializar todas las posiciones como vacías (nullptr = posición libre)
-    for (int i = 0; i < N; ++i) A[i] = nullptr;
-    return A;
-}
+struct SumaColumnas {
+    long long lotes;      // Slots colocados
+    long long unidades;   // Suma de cantidadTotal
+    double peso;          // Suma de pesoUnitario * cantidadTotal
+};
 
-// Libera la "matriz" (NO borra los lotes, solo el arreglo de punteros)
-// IMPORTANTE: Los lotes siguen existiendo en el sistema maestro
-void liberarAlmacen(LoteProduccion** A) {
-    delete[] A;  // Solo libera el arreglo de punteros, no los lotes referenciados
+struct KernelsColumnas {
+    const char* nombre;
+    int (*filtrarHasta)(const int* cantidad, int n, int umbral, int* sel);
+    void (*sumarColocados)(const int* cantidad, const float* peso, const int* celda, int n, SumaColumnas& s);
+};
+
+// Versión escalar: selección sin saltos (se escribe siempre y el contador avanza si cumple)
+int filtrarHastaEscalar(const int* cantidad, int n, int umbral, int* sel) {
+    int k = 0;
+    for (int i = 0; i < n; ++i) {
+        sel[k] = i;
+        k += (cantidad[i] <= umbral);
+    }
+    return k;
 }
 
-// Coloca puntero en (f,c) si está libre
-// ALGORITMO: Convierte coordenadas 2D a índice 1D y verifica disponibilidad
-// COMPLEJIDAD: O(1) - acceso directo por índice calculado
-bool colocar(LoteProduccion** A, int filas, int columnas, int f, int c, LoteProduccion* ptr) {
-    // Paso 1: Validar que las coordenadas estén dentro de los límites
-    if (f < 0 || f >= filas || c < 0 || c >= columnas) return false;
-    
-    // Paso 2: Convertir coordenadas 2D a índice 1D usando la fórmula de mapeo
-    int idx = f * columnas + c;  // FÓRMULA CLAVE: fila * total_columnas + columna
-    
-    // Paso 3: Verificar que la posición esté disponible
-    if (A[idx] != nullptr) return false;  // Posición ocupada
-    
-    // Paso 4: Colocar el puntero al lote en la posición calculada
-    A[idx] = ptr;
-    return true;  // Colocación exitosa
+void sumarColocadosEscalar(const int* cantidad, const float* peso, const int* celda, int n, SumaColumnas& s) {
+    for (int i = 0; i < n; ++i) {
+        if (celda[i] < 0) continue;
+        s.lotes++;
+        s.unidades += cantidad[i];
+        s.peso += (double)peso[i] * cantidad[i];
+    }
 }
 
-// Reporte por fila
-void reporteFila(LoteProduccion** A, int filas, int columnas, int f) {
-    if (f < 0 || f >= filas) return;
-    cout << "=== REPORTE DE FILA " << f << " ===" << endl;
-    for (int c = 0; c < columnas; ++c) {
-        int idx = f * columnas + c;
-        if (A[idx] == nullptr) {
-            cout << "Posición (" << f << ", " << c << "): VACÍA" << endl;
-        } else {
-            cout << "Posición (" << f << ", " << c << "): " << endl;
-            cout << "  ID: " << A[idx]->idLote << endl;
-            cout << "  Componente: " << A[idx]->nombreComponente << endl;
-            cout << "  Peso unitario: " << A[idx]->pesoUnitario << " kg" << endl;
-            cout << "  Cantidad: " << A[idx]->cantidadTotal << " unidades" << endl;
-        }
+#ifdef ALPHATECH_SIMD_X86
+// SSE2: 4 cantidades por comparación; las coincidencias se extraen bit a bit
+int filtrarHastaSSE2(const int* cantidad, int n, int umbral, int* sel) {
+    const __m128i u = _mm_set1_epi32(umbral);
+    int k = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(cantidad + i));
+        unsigned m = ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, u))) & 0xF;
+        for (; m; m &= m - 1) sel[k++] = i + __builtin_ctz(m);
+    }
+    for (; i < n; ++i) {
+        sel[k] = i;
+        k += (cantidad[i] <= umbral);
     }
+    return k;
 }
 
-// Buscar por nombre en todo el almacén
-bool buscarPorNombre(LoteProduccion** A, int filas, int columnas, const char* nombre) {
-    bool encontrado = false;
-    cout << "=== BÚSQUEDA POR COMPONENTE: " << nombre << " ===" << endl;
-    
-    for (int f = 0; f < filas; ++f) {
-        for (int c = 0; c < columnas; ++c) {
-            int idx = f * columnas + c;
-            if (A[idx] && strcmp(A[idx]->nombreComponente, nombre) == 0) {
-                cout << "Encontrado en posición (" << f << ", " << c << ")" << endl;
-                cout << "  ID Lote: " << A[idx]->idLote << endl;
-                cout << "  Cantidad: " << A[idx]->cantidadTotal << " unidades" << endl;
-                cout << "  Peso unitario: " << A[idx]->pesoUnitario << " kg" << endl;
-                encontrado = true;
-            }
-        }
+void sumarColocadosSSE2(const int* cantidad, const float* peso, const int* celda, int n, SumaColumnas& s) {
+    const __m128i menosUno = _mm_set1_epi32(-1);
+    __m128i lotes = _mm_setzero_si128(), unidades = _mm_setzero_si128();
+    __m128d pesoBajo = _mm_setzero_pd(), pesoAlto = _mm_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        // Máscara de colocados (celda >= 0); lo no colocado queda en cero
+        __m128i m = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(celda + i)), menosUno);
+        __m128i c = _mm_and_si128(m, _mm_loadu_si128((const __m128i*)(cantidad + i)));
+        __m128 w = _mm_and_ps(_mm_castsi128_ps(m), _mm_loadu_ps(peso + i));
+        lotes = _mm_sub_epi32(lotes, m);
+        
+        // Unidades en 64 bits (extensión de signo con srai + unpack)
+        __m128i signo = _mm_srai_epi32(c, 31);
+        unidades = _mm_add_epi64(unidades, _mm_unpacklo_epi32(c, signo));
+        unidades = _mm_add_epi64(unidades, _mm_unpackhi_epi32(c, signo));
+        
+        // Peso en double, dos carriles por mitad
+        pesoBajo = _mm_add_pd(pesoBajo, _mm_mul_pd(_mm_cvtepi32_pd(c), _mm_cvtps_pd(w)));
+        pesoAlto = _mm_add_pd(pesoAlto, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2))),
+                                                   _mm_cvtps_pd(_mm_movehl_ps(w, w))));
     }
-    return encontrado;
+    
+    int32_t l[4];
+    int64_t u[2];
+    double p[2];
+    _mm_storeu_si128((__m128i*)l, lotes);
+    _mm_storeu_si128((__m128i*)u, unidades);
+    _mm_storeu_pd(p, _mm_add_pd(pesoBajo, pesoAlto));
+    s.lotes += (long long)l[0] + l[1] + l[2] + l[3];
+    s.unidades += u[0] + u[1];
+    s.peso += p[0] + p[1];
+    sumarColocadosEscalar(cantidad + i, peso + i, celda + i, n - i, s);
 }
 
-// Buscar por ID en el almacén y devolver posición
-bool buscarPorID(LoteProduccion** A, int filas, int columnas, int id, int& fila, int& columna) {
-    for (int f = 0; f < filas; ++f) {
-        for (int c = 0; c < columnas; ++c) {
-            int idx = f * columnas + c;
-            if (A[idx] && A[idx]->idLote == id) {
-                fila = f;
-                columna = c;
-                return true;
+// Tabla de permutaciones para compactar: entrada m = posiciones de los bits en 1 de m,
+// empaquetadas de a un byte (la más baja primero)
+struct TablaCompactar {
+    uint64_t permutacion[256];
+    TablaCompactar() {
+        for (int m = 0; m < 256; ++m) {
+            uint64_t p = 0;
+            int k = 0;
+            for (int b = 0; b < 8; ++b) {
+                if (m & (1 << b)) p |= (uint64_t)b << (8 * k++);
             }
+            permutacion[m] = p;
         }
     }
-    return false;
-}
+};
+const TablaCompactar TABLA_COMPACTAR;
 
-// Remover lote del almacén (libera la posición)
-bool removerLote(LoteProduccion** A, Maestro& maestro, int filas, int columnas, int id) {
-    int f, c;
-    if (buscarPorID(A, filas, columnas, id, f, c)) {
-        int idx = f * columnas + c;
-        A[idx] = nullptr;  // Libera la posición en el almacén
-        maestroEliminar(maestro, id);  // Elimina del sistema maestro
-        return true;
+// AVX2: 8 cantidades por comparación y escritura compactada sin ciclo por coincidencia
+// (se escriben siempre 8 posiciones; como k <= i nunca se pasa del final de 'sel')
+__attribute__((target("avx2,popcnt")))
+int filtrarHastaAVX2(const int* cantidad, int n, int umbral, int* sel) {
+    const __m256i u = _mm256_set1_epi32(umbral);
+    const __m256i carriles = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int k = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(cantidad + i));
+        unsigned m = ~(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, u))) & 0xFF;
+        __m256i orden = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((long long)TABLA_COMPACTAR.permutacion[m]));
+        __m256i posiciones = _mm256_add_epi32(_mm256_set1_epi32(i), carriles);
+        _mm256_storeu_si256((__m256i*)(sel + k), _mm256_permutevar8x32_epi32(posiciones, orden));
+        k += __builtin_popcount(m);
     }
-    return false;
+    for (; i < n; ++i) {
+        sel[k] = i;
+        k += (cantidad[i] <= umbral);
+    }
+    return k;
 }
 
-// Mover lote de una posición a otra
-bool moverLote(LoteProduccion** A, int filas, int columnas, int filaOrigen, int colOrigen, int filaDestino, int colDestino) {
-    // Verificar límites
-    if (filaOrigen < 0 || filaOrigen >= filas || colOrigen < 0 || colOrigen >= columnas ||
-        filaDestino < 0 || filaDestino >= filas || colDestino < 0 || colDestino >= columnas) {
-        return false;
-    }
-    
-    int idxOrigen = filaOrigen * columnas + colOrigen;
-    int idxDestino = filaDestino * columnas + colDestino;
-    
-    // Verificar que origen tenga lote y destino esté vacío
-    if (A[idxOrigen] == nullptr || A[idxDestino] != nullptr) {
-        return false;
+__attribute__((target("avx2")))
+void sumarColocadosAVX2(const int* cantidad, const float* peso, const int* celda, int n, SumaColumnas& s) {
+    const __m256i menosUno = _mm256_set1_epi32(-1);
+    __m256i lotes = _mm256_setzero_si256();
+    __m256i unidadesBajo = _mm256_setzero_si256(), unidadesAlto = _mm256_setzero_si256();
+    __m256d pesoBajo = _mm256_setzero_pd(), pesoAlto = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // Máscara de colocados (celda >= 0); lo no colocado queda en cero
+        __m256i m = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(celda + i)), menosUno);
+        __m256i c = _mm256_and_si256(m, _mm256_loadu_si256((const __m256i*)(cantidad + i)));
+        __m256 w = _mm256_and_ps(_mm256_castsi256_ps(m), _mm256_loadu_ps(peso + i));
+        lotes = _mm256_sub_epi32(lotes, m);
+        
+        __m128i cBajo = _mm256_castsi256_si128(c), cAlto = _mm256_extracti128_si256(c, 1);
+        unidadesBajo = _mm256_add_epi64(unidadesBajo, _mm256_cvtepi32_epi64(cBajo));
+        unidadesAlto = _mm256_add_epi64(unidadesAlto, _mm256_cvtepi32_epi64(cAlto));
+        pesoBajo = _mm256_add_pd(pesoBajo, _mm256_mul_pd(_mm256_cvtepi32_pd(cBajo),
+                                                         _mm256_cvtps_pd(_mm256_castps256_ps128(w))));
+        pesoAlto = _mm256_add_pd(pesoAlto, _mm256_mul_pd(_mm256_cvtepi32_pd(cAlto),
+                                                         _mm256_cvtps_pd(_mm256_extractf128_ps(w, 1))));
     }
     
-    // Mover el lote
-    A[idxDestino] = A[idxOrigen];
-    A[idxOrigen] = nullptr;
+    int32_t l[8];
+    int64_t u[4];
+    double p[4];
+    _mm256_storeu_si256((__m256i*)l, lotes);
+    _mm256_storeu_si256((__m256i*)u, _mm256_add_epi64(unidadesBajo, unidadesAlto));
+    _mm256_storeu_pd(p, _mm256_add_pd(pesoBajo, pesoAlto));
+    for (int j = 0; j < 8; ++j) s.lotes += l[j];
+    s.unidades += u[0] + u[1] + u[2] + u[3];
+    s.peso += (p[0] + p[1]) + (p[2] + p[3]);
+    sumarColocadosEscalar(cantidad + i, peso + i, celda + i, n - i, s);
+}
+#endif
+
+// Variantes de la más simple a la más rápida
+const KernelsColumnas KERNELS_VARIANTES[] = {
+    {"escalar", filtrarHastaEscalar, sumarColocadosEscalar},
+#ifdef ALPHATECH_SIMD_X86
+    {"sse2", filtrarHastaSSE2, sumarColocadosSSE2},
+    {"avx2", filtrarHastaAVX2, sumarColocadosAVX2},
+#endif
+};
+const int NUM_KERNELS = sizeof(KERNELS_VARIANTES) / sizeof(KERNELS_VARIANTES[0]);
+
+// Indica si la CPU actual puede ejecutar la variante
+bool kernelsSoportados(const KernelsColumnas& k) {
+#ifdef ALPHATECH_SIMD_X86
+    if (strcmp(k.nombre, "avx2") == 0) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    if (strcmp(k.nombre, "sse2") == 0) return __builtin_cpu_supports("sse2");
+#endif
     return true;
 }
 
-// Función para mostrar estadísticas completas del almacén
-void mostrarEstadisticas(LoteProduccion** A, const Maestro& maestro, int filas, int columnas) {
-    int totalPosiciones = filas * columnas;
-    int posicionesOcupadas = 0;
-    int totalComponentes = 0;
-    float pesoTotal = 0.0f;
-    
-    cout << "\n=== ESTADÍSTICAS DEL ALMACÉN ===" << endl;
-    cout << "Dimensiones: " << filas << " x " << columnas << " = " << totalPosiciones << " posiciones" << endl;
-    
-    // Contar posiciones ocupadas y estadísticas
-    for (int i = 0; i < totalPosiciones; ++i) {
-        if (A[i] != nullptr) {
-            posicionesOcupadas++;
-            totalComponentes += A[i]->cantidadTotal;
-            pesoTotal += A[i]->pesoUnitario * A[i]->cantidadTotal;
-        }
+// Variante a usar: la más rápida que soporte la CPU (se decide en la primera llamada)
+const KernelsColumnas& kernelsColumnas() {
+    static const KernelsColumnas* elegidos = []() {
+        int i = NUM_KERNELS - 1;
+        while (i > 0 && !kernelsSoportados(KERNELS_VARIANTES[i])) --i;
+        return &KERNELS_VARIANTES[i];
+    }();
+    return *elegidos;
+}
+
+// Lotes, unidades y peso de todos los lotes colocados, leyendo solo columnas del maestro
+// COMPLEJIDAD: O(capacidad del maestro) secuencial, sin tocar el almacén
+SumaColumnas maestroSumarColocados(const Maestro& maestro) {
+    SumaColumnas s = {0, 0, 0.0};
+    const KernelsColumnas& k = kernelsColumnas();
+    for (int b = 0; b < maestro.nBloques; ++b) {
+        const BloqueMaestro* bloque = maestro.bloques[b];
+        k.sumarColocados(bloque->cantidadTotal, bloque->pesoUnitario, bloque->celda, MAESTRO_BLOQUE, s);
     }
-    
-    int posicionesLibres = totalPosiciones - posicionesOcupadas;
-    float porcentajeOcupacion = (float)posicionesOcupadas / totalPosiciones * 100.0f;
-    
-    cout << "Posiciones ocupadas: " << posicionesOcupadas << endl;
-    cout << "Posiciones libres: " << posicionesLibres << endl;
-    cout << "Porcentaje de ocupación: " << fixed << setprecision(1) << porcentajeOcupacion << "%" << endl;
+    return s;
+}
+
+/*======================================================================================
+SISTEMA DE ALMACÉN - MATRIZ 2D COMO ARREGLO 1D
+======================================================================================
+CONCEPTO CLAVE: MAPEO DE COORDENADAS 2D A ÍNDICE 1D
+- Una matriz de F filas y C columnas se almacena como un arreglo de tamaño F*C
+- Para acceder a la posición (fila, columna), usamos: índice = fila * columnas + columna
+- Ejemplo: En una matriz 3x4, la posición (1,2) se mapea al índice: 1*4+2 = 6
+
+MODOS DE ALMACENAMIENTO (mismas operaciones para ambos):
+• DENSO: arreglo de F*C slots del maestro (int, -1 = libre). Acceso directo O(1),
+  memoria O(F*C)
+  Disposición del arreglo (solo almacenPosicion la conoce):
+  - FILAS: f * columnas + c. Las filas son contiguas (16 celdas por línea de caché)
+  - BLOQUES: bloques de 4x4 celdas (64 bytes, una línea de caché alineada) en orden de
+    filas de bloques. Una columna o un vecino vertical usan 4 celdas de cada línea en
+    lugar de 1; un recorrido por filas usa 4 en lugar de 16. Se elige al crear el
+    almacén; compilando con -DALPHATECH_BLOQUES es la disposición por defecto
+• DISPERSO: solo se guardan las celdas ocupadas, en una tabla hash celda -> slot del
+  maestro. Memoria O(lotes); pensado para sitios con cientos de miles de posiciones
+  y baja ocupación. Los reportes recorren solo las celdas ocupadas.
+
+MAPA DE OCUPACIÓN: un bitset por fila (1 bit por celda, 1 = ocupada) junto a las celdas.
+Las filas se asignan al recibir su primer lote. Contar ocupación usa popcount y buscar
+celdas libres/ocupadas recorre palabras de 64 bits con count-trailing-zeros, así las
+estadísticas y los recorridos cuestan O(área/64) en lugar de O(área). En modo DISPERSO
+cada fila guarda solo sus palabras con algún lote (FilaDispersa, ordenadas por número
+de palabra): un lote por fila cuesta una palabra y no la fila entera, así la memoria
+sigue siendo O(lotes).
+
+TESELAS: el índice espacial es una grilla de teselas de ALTO_TESELA filas x 64 columnas
+(una palabra del mapa de ocupación en cada fila) con la cantidad de celdas ocupadas de
+cada una. Se actualiza en almacenMarcar, así colocar, moverLote, removerLote y
+redimensionar la mantienen sin pasos extra. Las consultas espaciales (rectángulo,
+celda libre más cercana) saltan las teselas vacías o llenas sin mirar sus filas.
+
+AGREGADOS: ocupación, unidades y peso total (suma compensada de Kahan en double), con
+subtotales por fila y por componente. Se actualizan en O(1) cada vez que una celda se
+ocupa o se vacía, así mostrarEstadisticas no necesita recorrer el almacén. Compilando
+con -DALPHATECH_VERIFICAR, mostrarEstadisticas además los recalcula todos recorriendo el
+almacén y el maestro (almacenVerificarAgregados, O(área/64 + lotes)); sin esa bandera
+no cuesta nada.
+
+IMPORTANTE: Las celdas referencian lotes del sistema maestro, no son copias
+======================================================================================*/
+const int ALMACEN_AUTO = -1;                   // Elegir modo según el área
+const int ALMACEN_DENSO = 0;
+const int ALMACEN_DISPERSO = 1;
+const long long UMBRAL_DISPERSO = 1 << 20;     // Área desde la cual AUTO elige disperso
+const int MAX_DIMENSION = 46340;               // Garantiza filas*columnas <= INT_MAX
+const int MAX_DETALLE = 20;                    // Ancho máximo para listar celdas vacías
+const int ALTO_TESELA = 64;                    // Filas por tesela del índice espacial
+const int DISPOSICION_FILAS = 0;               // Arreglo DENSO por filas
+const int DISPOSICION_BLOQUES = 1;             // Arreglo DENSO en bloques de 4x4
+#ifdef ALPHATECH_BLOQUES
+const int DISPOSICION_POR_DEFECTO = DISPOSICION_BLOQUES;
+#else
+const int DISPOSICION_POR_DEFECTO = DISPOSICION_FILAS;
+#endif
+
+// Bloque de 4x4 celdas del arreglo DENSO alineado a una línea de caché
+struct alignas(64) BloqueCeldas {
+    int slot[16];
+};
+
+// Cantidad de bits en 1 de una palabra (instrucción popcount)
+inline int contarBits(uint64_t x) {
+#if defined(_MSC_VER)
+    return (int)__popcnt64(x);
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// Posición del bit en 1 más bajo (x != 0)
+inline int bitMasBajo(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long i; _BitScanForward64(&i, x); return (int)i;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Posición del bit en 1 más alto (x != 0)
+inline int bitMasAlto(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long i; _BitScanReverse64(&i, x); return (int)i;
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+// Fila del mapa de ocupación en modo DISPERSO: solo las palabras con algún bit en 1,
+// ordenadas por número de palabra (la memoria se asigna con el primer lote de la fila
+// y se conserva aunque la fila vuelva a quedar vacía)
+struct FilaDispersa {
+    int n;
+    int cap;
+    uint16_t* palabra;         // Número de palabra (palabrasFila <= 725)
+    uint64_t* bits;
+};
+
+struct Almacen {
+    int filas;                 // Dimensiones del almacén
+    int columnas;
+    int modo;                  // ALMACEN_DENSO o ALMACEN_DISPERSO
+    int* celdas;               // DENSO: F*C slots del maestro (-1 = libre), en BloqueCeldas
+    int disposicion;           // DENSO: DISPOSICION_FILAS o DISPOSICION_BLOQUES
+    int bloquesFila;           // DENSO en bloques: bloques de 4x4 por fila de bloques
+    IndiceID disperso;         // DISPERSO: celda -> slot (IndiceID con la celda como clave)
+    uint64_t** ocupacion;      // DENSO: bitset por fila (nullptr = fila sin lotes todavía)
+    FilaDispersa* ocupacionDispersa;  // DISPERSO: palabras con lotes de cada fila
+    int palabrasFila;          // Palabras de 64 bits por fila
+    int* teselas;              // Celdas ocupadas por tesela: [banda de filas][palabra]
+    int bandas;                // Bandas de ALTO_TESELA filas
+    
+    // Agregados de los lotes colocados
+    int ocupadas;                          // Celdas ocupadas
+    long long unidades;                    // Suma de cantidadTotal
+    double peso;                           // Suma de pesoUnitario * cantidadTotal (Kahan)
+    double pesoCompensacion;               // Término de compensación de Kahan
+    int* ocupadasFila;                     // Subtotales por fila
+    long long* unidadesFila;
+    double* pesoFila;
+    vector<int> lotesComponente;           // Subtotales por nombreId
+    vector<long long> unidadesComponente;
+    vector<double> pesoComponente;
+};
+
+// Crea el almacén con todas las celdas vacías
+// PARÁMETROS: filas y columnas definen las dimensiones; modo DENSO, DISPERSO o AUTO;
+// disposición del arreglo DENSO (FILAS o BLOQUES)
+// RETORNA: Puntero al almacén creado
+Almacen* crearAlmacen(int filas, int columnas, int modo = ALMACEN_AUTO,
+                      int disposicion = DISPOSICION_POR_DEFECTO) {
+    Almacen* A = new Almacen;
+    A->filas = filas;
+    A->columnas = columnas;
+    if (modo == ALMACEN_AUTO) {
+        modo = ((long long)filas * columnas > UMBRAL_DISPERSO) ? ALMACEN_DISPERSO : ALMACEN_DENSO;
+    }
+    A->modo = modo;
+    A->celdas = nullptr;
+    A->disposicion = (modo == ALMACEN_DENSO) ? disposicion : DISPOSICION_FILAS;
+    A->bloquesFila = (columnas + 3) / 4;
+    
+    if (modo == ALMACEN_DENSO) {
+        // Calcular tamaño total necesario (en bloques: filas y columnas redondeadas a 4;
+        // 46340 es múltiplo de 4, así el área sigue cabiendo en un int)
+        long long N = (A->disposicion == DISPOSICION_BLOQUES)
+                    ? (long long)((filas + 3) / 4) * A->bloquesFila * 16
+                    : (long long)filas * columnas;
+        A->celdas = reinterpret_cast<int*>(new BloqueCeldas[(N + 15) / 16]);
+        // Inicializar todas las posiciones como vacías (-1 = posición libre)
+        for (long long i = 0; i < N; ++i) A->celdas[i] = -1;
+    } else {
+        indiceInit(A->disperso);  // Crece con los lotes, no con el área
+    }
+    
+    // Mapa de ocupación: las filas (DENSO) o sus palabras (DISPERSO) se crean al
+    // recibir su primer lote
+    A->palabrasFila = (columnas + 63) / 64;
+    A->ocupacion = nullptr;
+    A->ocupacionDispersa = nullptr;
+    if (modo == ALMACEN_DENSO) {
+        A->ocupacion = new uint64_t*[filas];
+        for (int f = 0; f < filas; ++f) A->ocupacion[f] = nullptr;
+    } else {
+        A->ocupacionDispersa = new FilaDispersa[filas];
+        for (int f = 0; f < filas; ++f) A->ocupacionDispersa[f] = {0, 0, nullptr, nullptr};
+    }
+    
+    // Índice espacial: todas las teselas vacías
+    A->bandas = (filas + ALTO_TESELA - 1) / ALTO_TESELA;
+    A->teselas = new int[A->bandas * A->palabrasFila];
+    for (int t = 0; t < A->bandas * A->palabrasFila; ++t) A->teselas[t] = 0;
+    
+    // Agregados en cero
+    A->ocupadas = 0;
+    A->unidades = 0;
+    A->peso = 0.0;
+    A->pesoCompensacion = 0.0;
+    A->ocupadasFila = new int[filas];
+    A->unidadesFila = new long long[filas];
+    A->pesoFila = new double[filas];
+    for (int f = 0; f < filas; ++f) {
+        A->ocupadasFila[f] = 0;
+        A->unidadesFila[f] = 0;
+        A->pesoFila[f] = 0.0;
+    }
+    return A;
+}
+
+// Libera el almacén (NO borra los lotes, solo la estructura de celdas)
+// IMPORTANTE: Los lotes siguen existiendo en el sistema maestro
+void liberarAlmacen(Almacen* A) {
+    if (A->modo == ALMACEN_DENSO) delete[] reinterpret_cast<BloqueCeldas*>(A->celdas);
+    else indiceFree(A->disperso);
+    for (int f = 0; A->ocupacion && f < A->filas; ++f) delete[] A->ocupacion[f];
+    delete[] A->ocupacion;
+    for (int f = 0; A->ocupacionDispersa && f < A->filas; ++f) {
+        delete[] A->ocupacionDispersa[f].palabra;
+        delete[] A->ocupacionDispersa[f].bits;
+    }
+    delete[] A->ocupacionDispersa;
+    delete[] A->teselas;
+    delete[] A->ocupadasFila;
+    delete[] A->unidadesFila;
+    delete[] A->pesoFila;
+    delete A;
+}
+
+// Verifica que (f,c) esté dentro del almacén
+inline bool almacenDentro(const Almacen& A, int f, int c) {
+    return f >= 0 && f < A.filas && c >= 0 && c < A.columnas;
+}
+
+// Posición de la palabra w en una fila dispersa (o donde habría que insertarla)
+// COMPLEJIDAD: O(log palabras con lotes de la fila)
+inline int filaDispersaBuscar(const FilaDispersa& fd, int w) {
+    return (int)(lower_bound(fd.palabra, fd.palabra + fd.n, (uint16_t)w) - fd.palabra);
+}
+
+// Palabra w del mapa de ocupación de la fila f (0 si no tiene lotes)
+inline uint64_t almacenPalabra(const Almacen& A, int f, int w) {
+    if (A.modo == ALMACEN_DENSO) {
+        const uint64_t* fila = A.ocupacion[f];
+        return fila != nullptr ? fila[w] : 0;
+    }
+    const FilaDispersa& fd = A.ocupacionDispersa[f];
+    if (fd.n == 0) return 0;
+    int i = filaDispersaBuscar(fd, w);
+    return (i < fd.n && fd.palabra[i] == w) ? fd.bits[i] : 0;
+}
+
+// Primera palabra >= w de la fila f con algún lote (palabrasFila si no hay más)
+inline int almacenSiguientePalabra(const Almacen& A, int f, int w) {
+    if (A.modo == ALMACEN_DENSO) {
+        const uint64_t* fila = A.ocupacion[f];
+        if (fila == nullptr) return A.palabrasFila;
+        while (w < A.palabrasFila && fila[w] == 0) ++w;
+        return w;
+    }
+    const FilaDispersa& fd = A.ocupacionDispersa[f];
+    int i = filaDispersaBuscar(fd, w);
+    return i < fd.n ? fd.palabra[i] : A.palabrasFila;
+}
+
+// Indica si (f,c) está ocupada según el mapa de ocupación
+inline bool almacenOcupadaFC(const Almacen& A, int f, int c) {
+    return (almacenPalabra(A, f, c >> 6) >> (c & 63)) & 1;
+}
+
+// Duplica la capacidad de una fila dispersa; con 'retirada' los arreglos viejos se
+// entregan ahí en lugar de liberarse (un lector sin candado puede estar leyéndolos)
+void filaDispersaCrecer(FilaDispersa& fd, FilaDispersa* retirada = nullptr) {
+    int cap = fd.cap == 0 ? 2 : fd.cap * 2;
+    uint16_t* palabra = new uint16_t[cap];
+    uint64_t* bits = new uint64_t[cap];
+    copy(fd.palabra, fd.palabra + fd.n, palabra);
+    copy(fd.bits, fd.bits + fd.n, bits);
+    if (retirada) {
+        *retirada = fd;
+    } else {
+        delete[] fd.palabra;
+        delete[] fd.bits;
+    }
+    publicar(fd.palabra, palabra);
+    publicar(fd.bits, bits);
+    fd.cap = cap;
+}
+
+// Pone o quita bits de la palabra w de una fila dispersa; las palabras que quedan en
+// cero se retiran. Una fila que se vacía conserva sus arreglos (se liberan con el
+// almacén): los lectores sin bloqueo pueden estar leyéndolos
+// Cada escritura se publica; la cantidad de palabras nunca supera la capacidad de los
+// arreglos publicados, así un lector sin candado no sale de ellos
+void filaDispersaMarcar(FilaDispersa& fd, int w, uint64_t bit, bool ocupada) {
+    int i = filaDispersaBuscar(fd, w);
+    bool existe = (i < fd.n && fd.palabra[i] == w);
+    if (ocupada) {
+        if (!existe) {
+            if (fd.n == fd.cap) filaDispersaCrecer(fd);
+            for (int k = fd.n; k > i; --k) {
+                publicar(fd.palabra[k], fd.palabra[k - 1]);
+                publicar(fd.bits[k], fd.bits[k - 1]);
+            }
+            publicar(fd.palabra[i], w);
+            publicar(fd.bits[i], 0);
+            publicar(fd.n, fd.n + 1);
+        }
+        publicar(fd.bits[i], fd.bits[i] | bit);
+        return;
+    }
+    if (!existe) return;
+    publicar(fd.bits[i], fd.bits[i] & ~bit);
+    if (fd.bits[i] != 0) return;
+    for (int k = i; k + 1 < fd.n; ++k) {
+        publicar(fd.palabra[k], fd.palabra[k + 1]);
+        publicar(fd.bits[k], fd.bits[k + 1]);
+    }
+    publicar(fd.n, fd.n - 1);
+}
+
+// Indica si una celda está ocupada
+inline bool almacenOcupada(const Almacen& A, int idx) {
+    return almacenOcupadaFC(A, idx / A.columnas, idx % A.columnas);
+}
+
+// Marca o desmarca una celda en el mapa de ocupación
+inline void almacenMarcar(Almacen& A, int idx, bool ocupada) {
+    int f = idx / A.columnas, c = idx % A.columnas;
+    uint64_t bit = (uint64_t)1 << (c & 63);
+    if (A.modo == ALMACEN_DENSO) {
+        if (A.ocupacion[f] == nullptr) {
+            if (!ocupada) return;
+            uint64_t* fila = new uint64_t[A.palabrasFila];
+            for (int w = 0; w < A.palabrasFila; ++w) fila[w] = 0;
+            publicar(A.ocupacion[f], fila);  // Ya en cero para los lectores sin bloqueo
+        }
+        uint64_t& palabra = A.ocupacion[f][c >> 6];
+        publicar(palabra, ocupada ? (palabra | bit) : (palabra & ~bit));
+    } else {
+        filaDispersaMarcar(A.ocupacionDispersa[f], c >> 6, bit, ocupada);
+    }
+    
+    // Una tesela abarca filas de varias franjas del acceso concurrente: suma atómica
+    int* cuenta = &A.teselas[(f / ALTO_TESELA) * A.palabrasFila + (c >> 6)];
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_fetch_add(cuenta, ocupada ? 1 : -1, __ATOMIC_RELAXED);
+#else
+    _InterlockedExchangeAdd((volatile long*)cuenta, ocupada ? 1 : -1);
+#endif
+}
+
+// Cantidad de celdas de la tesela (banda b, palabra w); las del borde son más chicas
+inline int almacenCeldasTesela(const Almacen& A, int b, int w) {
+    return min(ALTO_TESELA, A.filas - b * ALTO_TESELA) * min(64, A.columnas - w * 64);
+}
+
+// Palabra w de la fila f con las celdas LIBRES en 1 (sin bits fuera de las columnas)
+inline uint64_t almacenLibresPalabra(const Almacen& A, int f, int w) {
+    uint64_t libres = ~almacenPalabra(A, f, w);
+    int resto = A.columnas - w * 64;
+    if (resto < 64) libres &= ((uint64_t)1 << resto) - 1;
+    return libres;
+}
+
+// Cantidad de celdas ocupadas en una fila (popcount)
+int almacenOcupadasFila(const Almacen& A, int f) {
+    int total = 0;
+    for (int w = almacenSiguientePalabra(A, f, 0); w < A.palabrasFila; w = almacenSiguientePalabra(A, f, w + 1)) {
+        total += contarBits(almacenPalabra(A, f, w));
+    }
+    return total;
+}
+
+// Cantidad total de celdas ocupadas
+// COMPLEJIDAD: O(área/64) en filas con lotes
+int almacenContarOcupadas(const Almacen& A) {
+    int total = 0;
+    for (int f = 0; f < A.filas; ++f) total += almacenOcupadasFila(A, f);
+    return total;
+}
+
+// Primera columna libre de la fila f (-1 si la fila está llena)
+int almacenPrimeraLibreFila(const Almacen& A, int f) {
+    for (int w = 0; w < A.palabrasFila; ++w) {
+        uint64_t libres = almacenLibresPalabra(A, f, w);
+        if (libres) return w * 64 + bitMasBajo(libres);
+    }
+    return -1;
+}
+
+// Primera celda libre recorriendo filas en orden (false si el almacén está lleno)
+bool almacenPrimeraLibre(const Almacen& A, int& f, int& c) {
+    for (f = 0; f < A.filas; ++f) {
+        c = almacenPrimeraLibreFila(A, f);
+        if (c != -1) return true;
+    }
+    return false;
+}
+
+// Columna libre más cercana a c dentro de la palabra w de la fila f (-1 si no hay)
+// A igual distancia gana la de la izquierda
+inline int almacenLibreCercanaPalabra(const Almacen& A, int f, int w, int c) {
+    uint64_t libres = almacenLibresPalabra(A, f, w);
+    if (!libres) return -1;
+    if (c < w * 64) return w * 64 + bitMasBajo(libres);
+    if (c >= w * 64 + 64) return w * 64 + bitMasAlto(libres);
+    int bit = c & 63;
+    uint64_t derecha = libres & (~(uint64_t)0 << bit);
+    uint64_t izquierda = bit == 63 ? libres : libres & (((uint64_t)1 << (bit + 1)) - 1);
+    int cd = derecha ? w * 64 + bitMasBajo(derecha) : INT_MAX;
+    int ci = izquierda ? w * 64 + bitMasAlto(izquierda) : INT_MIN / 2;
+    return (c - ci <= (cd == INT_MAX ? INT_MAX : cd - c)) ? ci : cd;
+}
+
+// Celda libre más cercana a (f,c) en distancia Manhattan (false si el almacén está lleno)
+// A igual distancia gana la primera en orden (fila, columna)
+// ALGORITMO: Anillos de teselas alrededor de la tesela de (f,c). Las teselas llenas se
+// saltan con su contador y las del anillo r están a distancia >= (r-1)*64+1, así la
+// búsqueda termina en cuanto ningún anillo puede mejorar la mejor celda encontrada.
+// COMPLEJIDAD: O(teselas a distancia <= d + filas de las teselas no llenas revisadas),
+// con d la distancia a la celda libre; no depende del área del almacén
+bool almacenLibreMasCercana(const Almacen& A, int f, int c, int& fr, int& cr) {
+    if (A.ocupadas >= A.filas * A.columnas) return false;
+    int tb = f / ALTO_TESELA, tw = c >> 6;
+    int mejor = INT_MAX, mejorCelda = INT_MAX;
+    
+    for (int r = 0; ; ++r) {
+        if (r > 0 && (long long)(r - 1) * min(ALTO_TESELA, 64) + 1 > mejor) break;
+        if (tb - r < 0 && tb + r >= A.bandas && tw - r < 0 && tw + r >= A.palabrasFila) break;
+        
+        for (int b = max(tb - r, 0); b <= min(tb + r, A.bandas - 1); ++b) {
+            // En las bandas del borde del anillo se recorren todas sus teselas; en las
+            // interiores solo las dos de los extremos
+            bool borde = (b == tb - r || b == tb + r);
+            int paso = borde ? 1 : max(2 * r, 1);
+            for (int w = tw - r; w <= tw + r; w += paso) {
+                if (w < 0 || w >= A.palabrasFila) continue;
+                if (A.teselas[b * A.palabrasFila + w] == almacenCeldasTesela(A, b, w)) continue;
+                
+                int fi = b * ALTO_TESELA, ff = min(fi + ALTO_TESELA, A.filas) - 1;
+                int dc = c < w * 64 ? w * 64 - c : (c > w * 64 + 63 ? c - (w * 64 + 63) : 0);
+                int df = f < fi ? fi - f : (f > ff ? f - ff : 0);
+                if (df + dc > mejor) continue;
+                
+                // Filas de la tesela alejándose de la más cercana a f
+                int inicio = min(max(f, fi), ff);
+                for (int d = 0; inicio - d >= fi || inicio + d <= ff; ++d) {
+                    if (df + d + dc > mejor) break;
+                    for (int lado = 0; lado < (d == 0 ? 1 : 2); ++lado) {
+                        int fila = lado == 0 ? inicio + d : inicio - d;
+                        if (fila < fi || fila > ff) continue;
+                        int col = almacenLibreCercanaPalabra(A, fila, w, c);
+                        if (col == -1) continue;
+                        int dist = df + d + (col > c ? col - c : c - col);
+                        int celda = fila * A.columnas + col;
+                        if (dist < mejor || (dist == mejor && celda < mejorCelda)) {
+                            mejor = dist;
+                            mejorCelda = celda;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    fr = mejorCelda / A.columnas;
+    cr = mejorCelda % A.columnas;
+    return true;
+}
+
+// Posición de la celda (f,c) en el arreglo DENSO según su disposición
+inline int almacenPosicion(const Almacen& A, int f, int c) {
+    if (A.disposicion == DISPOSICION_FILAS) return f * A.columnas + c;
+    return ((f >> 2) * A.bloquesFila + (c >> 2)) * 16 + ((f & 3) << 2) + (c & 3);
+}
+
+inline int almacenPosicion(const Almacen& A, int idx) {
+    if (A.disposicion == DISPOSICION_FILAS) return idx;
+    return almacenPosicion(A, idx / A.columnas, idx % A.columnas);
+}
+
+// Devuelve el slot del maestro del lote de una celda (-1 si está vacía)
+inline int almacenSlot(const Almacen& A, int idx) {
+    if (A.modo == ALMACEN_DENSO) return A.celdas[almacenPosicion(A, idx)];
+    return indiceBuscar(A.disperso, idx);
+}
+
+// Igual que almacenSlot, con la fila y la columna ya separadas (sin división)
+inline int almacenSlotFC(const Almacen& A, int f, int c) {
+    if (A.modo == ALMACEN_DENSO) return A.celdas[almacenPosicion(A, f, c)];
+    return indiceBuscar(A.disperso, f * A.columnas + c);
+}
+
+// Suma (signo = +1) o resta (signo = -1) el lote del slot a los subtotales de la fila f
+// COMPLEJIDAD: O(1)
+void almacenAcumularFila(Almacen& A, const Maestro& maestro, int f, int slot, int signo) {
+    int cantidad = maestroCantidad(maestro, slot);
+    publicar(A.ocupadasFila[f], A.ocupadasFila[f] + signo);
+    publicar(A.unidadesFila[f], A.unidadesFila[f] + signo * (long long)cantidad);
+    publicar(A.pesoFila[f], A.pesoFila[f] + signo * (double)maestroPeso(maestro, slot) * cantidad);
+}
+
+// Suma o resta el lote del slot a los totales del almacén y de su componente
+// COMPLEJIDAD: O(1)
+void almacenAcumularTotales(Almacen& A, const Maestro& maestro, int slot, int signo) {
+    int cantidad = maestroCantidad(maestro, slot);
+    double pesoLote = signo * (double)maestroPeso(maestro, slot) * cantidad;
+    
+    A.ocupadas += signo;
+    A.unidades += signo * (long long)cantidad;
+    
+    // Suma compensada de Kahan: evita la deriva al sumar y restar muchos pesos
+    double y = pesoLote - A.pesoCompensacion;
+    double t = A.peso + y;
+    A.pesoCompensacion = (t - A.peso) - y;
+    A.peso = t;
+    
+    int nid = maestroNombreId(maestro, slot);
+    if (nid >= (int)A.lotesComponente.size()) {
+        A.lotesComponente.resize(nid + 1, 0);
+        A.unidadesComponente.resize(nid + 1, 0);
+        A.pesoComponente.resize(nid + 1, 0.0);
+    }
+    A.lotesComponente[nid] += signo;
+    A.unidadesComponente[nid] += signo * (long long)cantidad;
+    A.pesoComponente[nid] += pesoLote;
+}
+
+// Suma o resta el lote del slot a todos los agregados (fila, almacén y componente)
+inline void almacenAcumular(Almacen& A, const Maestro& maestro, int idx, int slot, int signo) {
+    almacenAcumularFila(A, maestro, idx / A.columnas, slot, signo);
+    almacenAcumularTotales(A, maestro, slot, signo);
+}
+
+// Escribe el slot en la celda y la marca como ocupada (sin tocar agregados)
+inline void almacenCeldaAsignar(Almacen& A, int idx, int slot) {
+    if (A.modo == ALMACEN_DENSO) publicar(A.celdas[almacenPosicion(A, idx)], slot);
+    else indiceInsertar(A.disperso, idx, slot);
+    almacenMarcar(A, idx, true);
+}
+
+// Vacía la celda y la marca como libre (sin tocar agregados)
+inline void almacenCeldaVaciar(Almacen& A, int idx) {
+    if (A.modo == ALMACEN_DENSO) publicar(A.celdas[almacenPosicion(A, idx)], -1);
+    else indiceEliminar(A.disperso, idx);
+    almacenMarcar(A, idx, false);
+}
+
+// Ocupa una celda con el lote del slot indicado
+inline void almacenPoner(Almacen& A, const Maestro& maestro, int idx, int slot) {
+    almacenCeldaAsignar(A, idx, slot);
+    almacenAcumular(A, maestro, idx, slot, +1);
+}
+
+// Vacía una celda ocupada por el lote del slot indicado
+inline void almacenQuitar(Almacen& A, const Maestro& maestro, int idx, int slot) {
+    almacenCeldaVaciar(A, idx);
+    almacenAcumular(A, maestro, idx, slot, -1);
+}
+
+// Agrega a 'celdas' las celdas ocupadas de las filas [filaIni, filaFin), en orden
+// COMPLEJIDAD: O(filas del rango + palabras con lotes de esas filas + k)
+void almacenOcupadas(const Almacen& A, int filaIni, int filaFin, vector<int>& celdas) {
+    for (int f = filaIni; f < filaFin; ++f) {
+        for (int w = almacenSiguientePalabra(A, f, 0); w < A.palabrasFila; w = almacenSiguientePalabra(A, f, w + 1)) {
+            // Extraer los bits en 1 de menor a mayor
+            for (uint64_t bits = almacenPalabra(A, f, w); bits; bits &= bits - 1) {
+                celdas.push_back(f * A.columnas + w * 64 + bitMasBajo(bits));
+            }
+        }
+    }
+}
+
+// Agrega a 'celdas' las celdas ocupadas del rectángulo [f0,f1] x [c0,c1] (recortado al
+// almacén), en orden (fila, columna)
+// ALGORITMO: Por cada banda de ALTO_TESELA filas se suman las teselas que cubren el
+// rango de columnas; una banda sin lotes se salta entera, y dentro de una banda solo se
+// leen las palabras de teselas con lotes de las filas con lotes
+// COMPLEJIDAD: O(teselas del rectángulo + palabras de teselas ocupadas + k)
+void almacenRango(const Almacen& A, int f0, int c0, int f1, int c1, vector<int>& celdas) {
+    f0 = max(f0, 0);
+    c0 = max(c0, 0);
+    f1 = min(f1, A.filas - 1);
+    c1 = min(c1, A.columnas - 1);
+    if (f0 > f1 || c0 > c1) return;
+    
+    int w0 = c0 >> 6, w1 = c1 >> 6;
+    uint64_t mascaraIni = ~(uint64_t)0 << (c0 & 63);
+    uint64_t mascaraFin = (c1 & 63) == 63 ? ~(uint64_t)0 : ((uint64_t)1 << ((c1 & 63) + 1)) - 1;
+    for (int b = f0 / ALTO_TESELA; b <= f1 / ALTO_TESELA; ++b) {
+        const int* teselas = A.teselas + b * A.palabrasFila;
+        int enBanda = 0;
+        for (int w = w0; w <= w1; ++w) enBanda += teselas[w];
+        if (enBanda == 0) continue;
+        
+        int fi = max(f0, b * ALTO_TESELA), ff = min(f1, b * ALTO_TESELA + ALTO_TESELA - 1);
+        for (int f = fi; f <= ff; ++f) {
+            if (A.ocupadasFila[f] == 0) continue;
+            for (int w = w0; w <= w1; ++w) {
+                if (teselas[w] == 0) continue;
+                uint64_t bits = almacenPalabra(A, f, w);
+                if (w == w0) bits &= mascaraIni;
+                if (w == w1) bits &= mascaraFin;
+                for (; bits; bits &= bits - 1) {
+                    celdas.push_back(f * A.columnas + w * 64 + bitMasBajo(bits));
+                }
+            }
+        }
+    }
+}
+
+// Agrega a 'celdas' las celdas de los k lotes colocados del componente 'nid' más cercanos
+// a (f,c) en distancia Manhattan, del más cercano al más lejano (a igual distancia, en
+// orden (fila, columna))
+// ALGORITMO: Recorre la lista por nombre del maestro y selecciona los k menores con
+// nth_element; solo se ordenan esos k
+// COMPLEJIDAD: O(m + k log k) con m = lotes del componente (no depende del área)
+void almacenCercanosComponente(const Almacen& A, const Maestro& maestro, int nid, int f, int c, int k,
+                               vector<int>& celdas) {
+    vector<pair<int, int>> candidatos;  // (distancia, celda)
+    for (int s = maestro.nombres.primero[nid]; s != -1; s = maestroSigNombre(maestro, s)) {
+        int celda = maestroCelda(maestro, s);
+        if (celda == -1) continue;
+        int df = celda / A.columnas - f, dc = celda % A.columnas - c;
+        candidatos.push_back({(df < 0 ? -df : df) + (dc < 0 ? -dc : dc), celda});
+    }
+    if ((int)candidatos.size() > k) {
+        nth_element(candidatos.begin(), candidatos.begin() + k, candidatos.end());
+        candidatos.resize(k);
+    }
+    sort(candidatos.begin(), candidatos.end());
+    for (const pair<int, int>& p : candidatos) celdas.push_back(p.second);
+}
+
+// Redimensiona el almacén conservando los lotes colocados
+// ALGORITMO: Una sola asignación para el nuevo almacén y una pasada sobre las celdas
+// ocupadas, recalculando cada índice con el nuevo ancho: (idx / C) * C' + (idx % C)
+// Los lotes que quedan fuera de los nuevos límites se sacan del almacén (siguen en el
+// maestro, sin posición) y sus IDs se devuelven en 'fuera' para informarlos; luego se
+// pueden volver a colocar con ubicarLote o eliminar con removerLote.
+// COMPLEJIDAD: O(celdas ocupadas + área/64) gracias al mapa de ocupación
+void redimensionarAlmacen(Almacen*& A, Maestro& maestro, int nuevasFilas, int nuevasColumnas, vector<int>& fuera) {
+    Almacen* N = crearAlmacen(nuevasFilas, nuevasColumnas, ALMACEN_AUTO, A->disposicion);
+    
+    vector<int> celdas;
+    almacenOcupadas(*A, 0, A->filas, celdas);
+    for (int idx : celdas) {
+        int f = idx / A->columnas, c = idx % A->columnas;
+        int slot = almacenSlot(*A, idx);
+        
+        if (!almacenDentro(*N, f, c)) {
+            maestroCelda(maestro, slot) = -1;
+            fuera.push_back(maestroId(maestro, slot));
+            continue;
+        }
+        int nuevo = f * nuevasColumnas + c;
+        almacenPoner(*N, maestro, nuevo, slot);
+        maestroCelda(maestro, slot) = nuevo;
+    }
+    
+    liberarAlmacen(A);
+    A = N;
+}
+
+// Coloca el lote del slot indicado en (f,c) si está libre y registra la celda en el maestro
+// ALGORITMO: Convierte coordenadas 2D a índice 1D y verifica disponibilidad
+// COMPLEJIDAD: O(1) - acceso directo (DENSO) o tabla hash (DISPERSO)
+bool colocar(Almacen& A, Maestro& maestro, int f, int c, int slot) {
+    METRICA_TIEMPO(MET_COLOCAR);
+    // Paso 1: Validar que las coordenadas estén dentro de los límites
+    if (!almacenDentro(A, f, c)) return false;
+    
+    // Paso 2: Convertir coordenadas 2D a índice 1D usando la fórmula de mapeo
+    int idx = f * A.columnas + c;  // FÓRMULA CLAVE: fila * total_columnas + columna
+    
+    // Paso 3: Verificar que la posición esté disponible
+    if (almacenOcupada(A, idx)) return false;  // Posición ocupada
+    
+    // Paso 4: Colocar el lote en la posición calculada
+    if (slot < 0 || slot >= maestro.cap || !maestroUsado(maestro, slot)) return false;  // No pertenece al maestro
+    almacenPoner(A, maestro, idx, slot);
+    
+    // Paso 5: Mantener sincronizado el índice ID -> celda
+    maestroCelda(maestro, slot) = idx;
+    return true;  // Colocación exitosa
+}
+
+// Agrega a 'celdas' las celdas ocupadas por los lotes con un nombre internado
+void celdasPorNombre(const Maestro& maestro, int nid, vector<int>& celdas) {
+    for (int s = maestro.nombres.primero[nid]; s != -1; s = maestroSigNombre(maestro, s)) {
+        if (maestroCelda(maestro, s) != -1) celdas.push_back(maestroCelda(maestro, s));
+    }
+}
+
+// Buscar por ID en el almacén y devolver posición
+// COMPLEJIDAD: O(1) - índice hash ID -> slot y celda guardada en el slot
+bool buscarPorID(const Maestro& maestro, int columnas, int id, int& fila, int& columna) {
+    int slot = maestroBuscarID(maestro, id);
+    if (slot == -1) return false;
+    
+    int idx = maestroCelda(maestro, slot);
+    if (idx == -1) return false;  // Existe en el maestro pero no está colocado
+    
+    fila = idx / columnas;
+    columna = idx % columnas;
+    return true;
+}
+
+// Remover lote del almacén (libera la posición)
+// Los lotes sin posición (tras redimensionar o reinicializar) solo salen del maestro
+bool removerLote(Almacen& A, Maestro& maestro, int id) {
+    METRICA_TIEMPO(MET_REMOVER);
+    int slot = maestroBuscarID(maestro, id);
+    if (slot == -1) return false;
+    
+    if (maestroCelda(maestro, slot) != -1) {
+        almacenQuitar(A, maestro, maestroCelda(maestro, slot), slot);  // Libera la posición en el almacén
+    }
+    maestroEliminar(maestro, id);  // Elimina del sistema maestro (y del índice)
+    return true;
+}
+
+// Coloca un lote ya registrado que quedó sin posición (tras redimensionar o reinicializar)
+// RETORNA: slot del lote, o -1 si no existe, ya está colocado o la celda no está libre
+int ubicarLote(Almacen& A, Maestro& maestro, int id, int f, int c) {
+    int slot = maestroBuscarID(maestro, id);
+    if (slot == -1 || maestroCelda(maestro, slot) != -1) return -1;
+    return colocar(A, maestro, f, c, slot) ? slot : -1;
+}
+
+// Mover lote de una posición a otra
+bool moverLote(Almacen& A, Maestro& maestro, int filaOrigen, int colOrigen, int filaDestino, int colDestino) {
+    METRICA_TIEMPO(MET_MOVER);
+    // Verificar límites
+    if (!almacenDentro(A, filaOrigen, colOrigen) || !almacenDentro(A, filaDestino, colDestino)) {
+        return false;
+    }
+    
+    int idxOrigen = filaOrigen * A.columnas + colOrigen;
+    int idxDestino = filaDestino * A.columnas + colDestino;
+    
+    // Verificar que origen tenga lote y destino esté vacío
+    int slot = almacenSlot(A, idxOrigen);
+    if (slot == -1 || almacenOcupada(A, idxDestino)) {
+        return false;
+    }
+    
+    // Mover el lote y actualizar su celda en el maestro
+    almacenQuitar(A, maestro, idxOrigen, slot);
+    almacenPoner(A, maestro, idxDestino, slot);
+    maestroCelda(maestro, slot) = idxDestino;
+    return true;
+}
+
+#ifdef ALPHATECH_VERIFICAR
+// Verificador de depuración: recalcula los agregados por caminos independientes
+// (popcount del mapa de ocupación por fila y por tesela, suma vectorial de las
+// columnas del maestro y una pasada por los lotes colocados para los subtotales por
+// fila y por componente) y los compara con los valores mantenidos incrementalmente.
+// También cruza cada celda ocupada con su lote: el slot debe estar en uso y tener esa
+// celda, y no puede haber slots en celdas sin marcar en el mapa de ocupación
+bool almacenVerificarAgregados(const Almacen& A, const Maestro& maestro) {
+    bool ok = true;
+    int ocupadas = 0;
+    vector<int> teselas(A.bandas * A.palabrasFila, 0);
+    for (int f = 0; f < A.filas; ++f) {
+        int enFila = almacenOcupadasFila(A, f);
+        ok = ok && (enFila == A.ocupadasFila[f]);
+        ocupadas += enFila;
+        for (int w = almacenSiguientePalabra(A, f, 0); w < A.palabrasFila; w = almacenSiguientePalabra(A, f, w + 1)) {
+            teselas[(f / ALTO_TESELA) * A.palabrasFila + w] += contarBits(almacenPalabra(A, f, w));
+        }
+    }
+    ok = ok && equal(teselas.begin(), teselas.end(), A.teselas);
+    
+    // Celda -> slot -> celda: con tantos lotes colocados como celdas (abajo) es una
+    // correspondencia uno a uno
+    vector<int> celdas;
+    almacenOcupadas(A, 0, A.filas, celdas);
+    for (int idx : celdas) {
+        int slot = almacenSlot(A, idx);
+        ok = ok && slot >= 0 && slot < maestro.cap && maestroUsado(maestro, slot)
+                && maestroCelda(maestro, slot) == idx;
+    }
+    
+    // Slots sin bit en el mapa (DENSO: recorrido completo de las celdas)
+    if (A.modo == ALMACEN_DENSO) {
+        int conSlot = 0;
+        for (int f = 0; f < A.filas; ++f) {
+            for (int c = 0; c < A.columnas; ++c) conSlot += (almacenSlotFC(A, f, c) != -1);
+        }
+        ok = ok && (conSlot == ocupadas);
+    } else {
+        ok = ok && (A.disperso.size == ocupadas);
+    }
+    
+    SumaColumnas s = maestroSumarColocados(maestro);
+    ok = ok && (ocupadas == A.ocupadas) && (s.lotes == A.ocupadas) && (s.unidades == A.unidades);
+    ok = ok && (fabs(s.peso - A.peso) <= 1e-6 * (1.0 + fabs(s.peso)));
+    
+    // Subtotales por fila y por componente desde la celda de cada lote del maestro
+    // (sumas sin compensar: se toleran errores relativos al peso total del almacén)
+    double tolerancia = 1e-6 * (1.0 + fabs(s.peso));
+    vector<long long> unidadesFila(A.filas, 0);
+    vector<double> pesoFila(A.filas, 0.0);
+    size_t componentes = A.lotesComponente.size();
+    vector<int> lotesComponente(componentes, 0);
+    vector<long long> unidadesComponente(componentes, 0);
+    vector<double> pesoComponente(componentes, 0.0);
+    for (int i = 0; i < maestro.cap; ++i) {
+        if (!maestroUsado(maestro, i) || maestroCelda(maestro, i) == -1) continue;
+        int f = maestroCelda(maestro, i) / A.columnas;
+        int nid = maestroNombreId(maestro, i);
+        int cantidad = maestroCantidad(maestro, i);
+        double pesoLote = (double)maestroPeso(maestro, i) * cantidad;
+        if (f >= A.filas || nid >= (int)componentes) {
+            ok = false;
+            continue;
+        }
+        unidadesFila[f] += cantidad;
+        pesoFila[f] += pesoLote;
+        lotesComponente[nid]++;
+        unidadesComponente[nid] += cantidad;
+        pesoComponente[nid] += pesoLote;
+    }
+    for (int f = 0; f < A.filas; ++f) {
+        ok = ok && (unidadesFila[f] == A.unidadesFila[f]);
+        ok = ok && (fabs(pesoFila[f] - A.pesoFila[f]) <= tolerancia);
+    }
+    for (size_t n = 0; n < componentes; ++n) {
+        ok = ok && (lotesComponente[n] == A.lotesComponente[n]);
+        ok = ok && (unidadesComponente[n] == A.unidadesComponente[n]);
+        ok = ok && (fabs(pesoComponente[n] - A.pesoComponente[n]) <= tolerancia);
+    }
+    
+    if (!ok) cout << "✗ ERROR INTERNO: agregados del almacén inconsistentes" << endl;
+    return ok;
+}
+#endif
+
+// Función para mostrar estadísticas completas del almacén
+// COMPLEJIDAD: O(1) - usa los agregados mantenidos en cada operación
+void mostrarEstadisticas(const Almacen& A, const Maestro& maestro) {
+    int totalPosiciones = A.filas * A.columnas;
+    int posicionesOcupadas = A.ocupadas;
+    long long totalComponentes = A.unidades;
+    double pesoTotal = A.peso;
+    
+    cout << "\n=== ESTADÍSTICAS DEL ALMACÉN ===" << endl;
+    cout << "Dimensiones: " << A.filas << " x " << A.columnas << " = " << totalPosiciones << " posiciones" << endl;
+    
+    int posicionesLibres = totalPosiciones - posicionesOcupadas;
+    float porcentajeOcupacion = (float)posicionesOcupadas / totalPosiciones * 100.0f;
+    
+    cout << "Posiciones ocupadas: " << posicionesOcupadas << endl;
+    cout << "Posiciones libres: " << posicionesLibres << endl;
+    cout << "Porcentaje de ocupación: " << fixed << setprecision(1) << porcentajeOcupacion << "%" << endl;
     cout << "Total de lotes activos: " << maestro.size << endl;
     cout << "Total de componentes: " << totalComponentes << " unidades" << endl;
     cout << "Peso total almacenado: " << fixed << setprecision(2) << pesoTotal << " kg" << endl;
@@ -401,360 +2004,4866 @@ void mostrarEstadisticas(LoteProduccion** A, const Maestro& maestro, int filas,
     } else if (porcentajeOcupacion > 75.0f) {
         cout << "ADVERTENCIA: Almacén con alta ocupación (" << porcentajeOcupacion << "%)" << endl;
     }
+    
+#ifdef ALPHATECH_VERIFICAR
+    bool consistente = almacenVerificarAgregados(A, maestro);
+    assert(consistente);
+    (void)consistente;
+#endif
+}
+
+/*======================================================================================
+COLOCACIÓN EN BLOQUE (RECEPCIÓN DE UN CAMIÓN)
+======================================================================================
+colocarLotes recibe n lotes nuevos y una política de ubicación y los coloca TODOS o
+NINGUNO: si el lote se rechaza, el almacén y el maestro quedan como estaban.
+  POLITICA_FILAS       primeras celdas libres en orden (fila, columna)
+  POLITICA_COMPONENTE  agrupa los lotes por componente y ubica cada grupo alrededor de
+                       un lote ya almacenado del mismo componente; un componente sin
+                       lotes colocados sigue a continuación del grupo anterior
+  POLITICA_MUELLE      las n celdas libres más cercanas al muelle (f,c); los lotes más
+                       pesados (peso x cantidad) van a las más cercanas, lo que minimiza
+                       la suma de peso x distancia al muelle sobre esas celdas
+Fases:
+1. Validación sin tocar el estado: valores, IDs repetidos (dentro del lote o ya en el
+   maestro) y celdas libres suficientes. Pasada esta fase ningún paso puede fallar.
+2. Elección de celdas con el mapa de ocupación y el índice de teselas. Cada celda
+   elegida se marca en el mapa (reserva) para que las búsquedas siguientes la salten;
+   las marcas se retiran al terminar la fase.
+3. Confirmación: la capacidad del maestro y de su índice se reserva de una vez y cada
+   lote pasa por maestroCrear + colocar (mismos agregados que un lote suelto).
+En el diario el lote va precedido de un registro DIARIO_LOTES con su tamaño; al
+reproducir, un lote cortado a medias (corte de energía) se descarta entero.
+COMPLEJIDAD: FILAS O(filas recorridas + n); COMPONENTE y MUELLE O(n log n + n búsquedas
+de almacenLibreMasCercana), que dependen de la distancia a las celdas libres y no del
+área del almacén (ubicar cada lote con almacenPrimeraLibre es O(n · área/64))
+======================================================================================*/
+const int POLITICA_FILAS = 0;
+const int POLITICA_COMPONENTE = 1;
+const int POLITICA_MUELLE = 2;
+
+// Resultado de colocarLotes
+const int LOTES_OK = 0;
+const int LOTES_VALOR = 1;          // ID, nombre, peso o cantidad inválidos
+const int LOTES_ID_DUPLICADO = 2;   // ID repetido en el lote o ya existente
+const int LOTES_LLENO = 3;          // Menos celdas libres que lotes
+const int LOTES_POSICION = 4;       // Muelle fuera del almacén
+
+// Celda de algún lote colocado del componente 'nid' (-1 si no tiene ninguno)
+int celdaComponente(const Maestro& maestro, int nid) {
+    for (int s = maestro.nombres.primero[nid]; s != -1; s = maestroSigNombre(maestro, s)) {
+        if (maestroCelda(maestro, s) != -1) return maestroCelda(maestro, s);
+    }
+    return -1;
+}
+
+// Escribe en 'celdas' las primeras n celdas libres en orden (fila, columna)
+// COMPLEJIDAD: O(filas recorridas + palabras de las filas con espacio + n); las filas
+// llenas se saltan con su subtotal
+void elegirCeldasFilas(const Almacen& A, int n, int* celdas) {
+    int k = 0;
+    for (int f = 0; f < A.filas && k < n; ++f) {
+        if (A.ocupadasFila[f] == A.columnas) continue;
+        for (int w = 0; w < A.palabrasFila && k < n; ++w) {
+            for (uint64_t libres = almacenLibresPalabra(A, f, w); libres && k < n; libres &= libres - 1) {
+                celdas[k++] = f * A.columnas + w * 64 + bitMasBajo(libres);
+            }
+        }
+    }
+}
+
+// Reserva en el mapa de ocupación la celda libre más cercana a (f,c)
+// Solo para la fase de elección: la celda no se cuenta en los agregados
+// RETORNA: La celda reservada (debe quedar al menos una libre)
+int reservarLibreCercana(Almacen& A, int f, int c) {
+    int fr, cr;
+    almacenLibreMasCercana(A, f, c, fr, cr);
+    int celda = fr * A.columnas + cr;
+    almacenMarcar(A, celda, true);
+    return celda;
 }
 
-// Reporte completo del almacén (todas las posiciones)
-void reporteCompleto(LoteProduccion** A, int filas, int columnas) {
-    cout << "\n=== REPORTE COMPLETO DEL ALMACÉN ===" << endl;
+// Coloca n lotes nuevos según la política, todos o ninguno (ver arriba)
+// 'celdas' recibe la celda asignada a cada lote, en el orden de 'lotes'. Si se rechaza,
+// 'fallido' indica el lote que lo impidió (-1 si el motivo es el lote entero)
+// RETORNA: LOTES_OK o el motivo del rechazo
+int colocarLotes(Almacen& A, Maestro& maestro, const LoteProduccion* lotes, int n, int politica,
+                 int fMuelle, int cMuelle, int* celdas, int& fallido) {
+    METRICA_TIEMPO(MET_COLOCAR_LOTES);
+    fallido = -1;
     
-    for (int f = 0; f < filas; ++f) {
-        cout << "\n--- FILA " << f << " ---" << endl;
-        for (int c = 0; c < columnas; ++c) {
-            int idx = f * columnas + c;
-            cout << "Pos (" << f << "," << c << "): ";
-            
-            if (A[idx] == nullptr) {
-                cout << "VACÍA" << endl;
+    // Paso 1: Validar sin tocar el estado
+    if (politica == POLITICA_MUELLE && !almacenDentro(A, fMuelle, cMuelle)) return LOTES_POSICION;
+    for (int i = 0; i < n; ++i) {
+        const LoteProduccion& lote = lotes[i];
+        fallido = i;
+        if (lote.idLote < 1 || lote.nombreComponente[0] == '\0' || !(lote.pesoUnitario > 0.0f)
+            || lote.cantidadTotal < 1) return LOTES_VALOR;
+        if (maestroBuscarID(maestro, lote.idLote) != -1) return LOTES_ID_DUPLICADO;
+    }
+    fallido = -1;
+    vector<int> orden(n);
+    for (int i = 0; i < n; ++i) orden[i] = i;
+    sort(orden.begin(), orden.end(), [&](int x, int y) {
+        return lotes[x].idLote != lotes[y].idLote ? lotes[x].idLote < lotes[y].idLote : x < y;
+    });
+    for (int i = 1; i < n; ++i) {
+        if (lotes[orden[i]].idLote == lotes[orden[i - 1]].idLote) {
+            fallido = orden[i];
+            return LOTES_ID_DUPLICADO;
+        }
+    }
+    if ((long long)A.filas * A.columnas - A.ocupadas < n) return LOTES_LLENO;
+    if (n == 0) return LOTES_OK;
+    
+    // Paso 2: Elegir las celdas (las reservas se marcan en el mapa y luego se retiran)
+    if (politica == POLITICA_FILAS) {
+        elegirCeldasFilas(A, n, celdas);
+    } else if (politica == POLITICA_MUELLE) {
+        // Las reservas salen en distancia creciente: los más pesados primero
+        for (int i = 0; i < n; ++i) orden[i] = i;
+        stable_sort(orden.begin(), orden.end(), [&](int x, int y) {
+            return (double)lotes[x].pesoUnitario * lotes[x].cantidadTotal
+                 > (double)lotes[y].pesoUnitario * lotes[y].cantidadTotal;
+        });
+        for (int i : orden) celdas[i] = reservarLibreCercana(A, fMuelle, cMuelle);
+    } else {
+        // Grupos por nombre; cada grupo alrededor de su ancla
+        for (int i = 0; i < n; ++i) orden[i] = i;
+        stable_sort(orden.begin(), orden.end(), [&](int x, int y) {
+            return strncmp(lotes[x].nombreComponente, lotes[y].nombreComponente, NOMBRE_MAX - 1) < 0;
+        });
+        int anterior = -1;  // Última celda reservada por el grupo anterior
+        for (int g = 0; g < n; ) {
+            char nombre[NOMBRE_MAX];
+            strncpy(nombre, lotes[orden[g]].nombreComponente, NOMBRE_MAX - 1);
+            nombre[NOMBRE_MAX - 1] = '\0';
+            int nid = nombresBuscar(maestro.nombres, nombre);
+            int ancla = nid != -1 ? celdaComponente(maestro, nid) : -1;
+            if (ancla == -1) ancla = anterior;
+            int fa = 0, ca = 0;
+            if (ancla != -1) {
+                fa = ancla / A.columnas;
+                ca = ancla % A.columnas;
             } else {
-                cout << "ID:" << A[idx]->idLote 
-                     << " | " << A[idx]->nombreComponente 
-                     << " | " << A[idx]->cantidadTotal << " uds"
-                     << " | " << A[idx]->pesoUnitario << " kg/ud" << endl;
+                almacenPrimeraLibre(A, fa, ca);
+            }
+            for (; g < n && strncmp(lotes[orden[g]].nombreComponente, nombre, NOMBRE_MAX - 1) == 0; ++g) {
+                anterior = celdas[orden[g]] = reservarLibreCercana(A, fa, ca);
             }
         }
     }
+    if (politica != POLITICA_FILAS) {
+        for (int i = 0; i < n; ++i) almacenMarcar(A, celdas[i], false);
+    }
+    
+    // Paso 3: Confirmar (nada puede fallar a partir de aquí)
+    maestroReservarCapacidad(maestro, n);
+    for (int i = 0; i < n; ++i) {
+        const LoteProduccion& lote = lotes[i];
+        int slot = maestroCrear(maestro, lote.idLote, lote.nombreComponente, lote.pesoUnitario,
+                                lote.cantidadTotal);
+        colocar(A, maestro, celdas[i] / A.columnas, celdas[i] % A.columnas, slot);
+    }
+    return LOTES_OK;
 }
 
 /*======================================================================================
-SISTEMA DE PILA PARA HISTORIAL DE INSPECCIONES
+SALIDA CON BÚFER Y MOTOR DE REPORTES
+======================================================================================
+Los reportes (completo, por fila y por componente) se formatean con to_chars en un
+búfer propio de TAM_SALIDA_LOTE bytes que se escribe de una vez al llenarse, en lugar
+de varios cout << ... << endl por celda (cada endl vacía la salida). Destinos:
+- streambuf: el de cout en ese momento (respeta las redirecciones del modo por lotes y
+  de la medición); se sincroniza una sola vez al terminar el reporte
+- Descriptor de archivo: write() directo, sin iostreams (archivos y tuberías)
+- FILE*: fwrite (respuestas del modo por lotes y JSON de la medición)
+FORMATOS:
+- TEXTO: el reporte legible de siempre, idéntico byte a byte (los decimales siguen el
+  estado actual de cout, p. ej. fixed/setprecision)
+- TABLA: una línea por lote con columnas alineadas, sin posiciones vacías
+- CSV:   encabezado + fila,columna,id,componente,peso,cantidad (comillas RFC 4180)
+- JSON:  {"reporte":"<tipo>","lotes":[{...}, ...]}
+Los formatos de máquina se piden con REPORT en el modo por lotes (a un archivo) o con
+alphatech --reporte [texto|tabla|csv|json] (reporte completo a la salida estándar).
+COMPLEJIDAD: O(lotes listados), con una escritura al sistema cada 64 KB
+======================================================================================*/
+const size_t TAM_SALIDA_LOTE = 1 << 16;       // 64 KB por escritura
+
+enum FormatoReporte { REPORTE_TEXTO, REPORTE_TABLA, REPORTE_CSV, REPORTE_JSON };
+
+// Salida con búfer propio (una escritura cada TAM_SALIDA_LOTE bytes)
+struct SalidaLote {
+    char* buf;
+    size_t n;
+    FILE* destino;       // fwrite, si no hay flujo ni descriptor
+    streambuf* flujo;    // sputn
+    int fd;              // write() directo (-1 = no se usa)
+    bool error;          // Alguna escritura falló
+    void (*antesDeEscribir)(void*);  // Se llama antes de cada escritura al destino
+    void* contexto;                  // (el modo por lotes confirma ahí el diario)
+};
+
+void salidaInit(SalidaLote& S, FILE* destino) {
+    S.buf = new char[TAM_SALIDA_LOTE];
+    S.n = 0;
+    S.destino = destino;
+    S.flujo = nullptr;
+    S.fd = -1;
+    S.error = false;
+    S.antesDeEscribir = nullptr;
+    S.contexto = nullptr;
+}
+
+void salidaInitFlujo(SalidaLote& S, streambuf* flujo) {
+    salidaInit(S, nullptr);
+    S.flujo = flujo;
+}
+
+void salidaInitDescriptor(SalidaLote& S, int fd) {
+    salidaInit(S, nullptr);
+    S.fd = fd;
+}
+
+void salidaEscribir(SalidaLote& S, const char* datos, size_t n) {
+    if (S.flujo) {
+        if (S.flujo->sputn(datos, (streamsize)n) != (streamsize)n) S.error = true;
+        return;
+    }
+#ifdef ALPHATECH_MMAP
+    if (S.fd >= 0) {
+        while (n > 0) {
+            ssize_t escritos = write(S.fd, datos, n);
+            if (escritos < 0 && errno == EINTR) continue;
+            if (escritos <= 0) {
+                S.error = true;
+                return;
+            }
+            datos += escritos;
+            n -= (size_t)escritos;
+        }
+        return;
+    }
+#endif
+    if (!S.destino || fwrite(datos, 1, n, S.destino) != n) S.error = true;
+}
+
+void salidaVaciar(SalidaLote& S) {
+    if (S.n == 0) return;
+    if (S.antesDeEscribir) S.antesDeEscribir(S.contexto);
+    salidaEscribir(S, S.buf, S.n);
+    S.n = 0;
+}
+
+// Vacía el búfer propio y el del destino, para que lo escrito llegue ya al lector
+void salidaEntregar(SalidaLote& S) {
+    salidaVaciar(S);
+    if (S.flujo && S.flujo->pubsync() != 0) S.error = true;
+    if (S.destino && fflush(S.destino) != 0) S.error = true;
+}
+
+// Vacía el búfer, sincroniza el destino y libera el búfer
+// RETORNA: true si todas las escrituras tuvieron éxito
+bool salidaFree(SalidaLote& S) {
+    salidaEntregar(S);
+    delete[] S.buf;
+    S.buf = nullptr;
+    return !S.error;
+}
+
+// Abre un archivo de reporte como destino (descriptor directo donde hay POSIX)
+bool salidaAbrirArchivo(SalidaLote& S, const char* nombreArchivo) {
+#ifdef ALPHATECH_MMAP
+    int fd = open(nombreArchivo, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    salidaInitDescriptor(S, fd);
+#else
+    FILE* archivo = fopen(nombreArchivo, "wb");
+    if (!archivo) return false;
+    salidaInit(S, archivo);
+#endif
+    return true;
+}
+
+// RETORNA: true si todo el reporte llegó al archivo
+bool salidaCerrarArchivo(SalidaLote& S) {
+    FILE* archivo = S.destino;
+    int fd = S.fd;
+    bool ok = salidaFree(S);
+#ifdef ALPHATECH_MMAP
+    if (fd >= 0 && close(fd) != 0) ok = false;
+#else
+    (void)fd;
+#endif
+    if (archivo && fclose(archivo) != 0) ok = false;
+    return ok;
+}
+
+void salidaTexto(SalidaLote& S, string_view t) {
+    if (S.n + t.size() > TAM_SALIDA_LOTE) salidaVaciar(S);
+    if (t.size() > TAM_SALIDA_LOTE) {
+        if (S.antesDeEscribir) S.antesDeEscribir(S.contexto);
+        salidaEscribir(S, t.data(), t.size());
+        return;
+    }
+    memcpy(S.buf + S.n, t.data(), t.size());
+    S.n += t.size();
+}
+
+// Números sin iostream ni locale: to_chars sobre un búfer local
+template <typename T>
+void salidaNumero(SalidaLote& S, T valor) {
+    char num[32];
+    to_chars_result r = to_chars(num, num + sizeof(num), valor);
+    salidaTexto(S, string_view(num, r.ptr - num));
+}
+
+void salidaDecimal(SalidaLote& S, double valor, int decimales = 3) {
+    char num[64];
+    to_chars_result r = to_chars(num, num + sizeof(num), valor, chars_format::fixed, decimales);
+    salidaTexto(S, string_view(num, r.ptr - num));
+}
+
+const double POTENCIAS_10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+// Camino rápido de printf("%.*f") y printf("%.*g") para un float (los pesos)
+// ALGORITMO: Un float tiene 24 bits de mantisa y 5^9 ocupa 21 bits, así que |v| * 10^d
+// con d <= 9 es exacto en double; nearbyint lo redondea igual que printf (mitad al par)
+// y el entero resultante se escribe con el punto insertado. En formato general 'cifras'
+// son las cifras significativas y se quitan los ceros sobrantes.
+// RETORNA: fin del texto, o nullptr si el valor no entra en el camino rápido
+// (notación científica, |v| >= 1e9, NaN, más de 9 decimales)
+char* decimalRapido(char* p, float valor, int cifras, bool general) {
+    double a = fabs((double)valor);
+    if (!(a < 1e9)) return nullptr;
+    int decimales = cifras;
+    if (general) {
+        int significativas = max(cifras, 1);
+        int x = 0;  // Exponente decimal: 10^x <= a < 10^(x+1)
+        if (a >= 1.0) {
+            while (a >= POTENCIAS_10[x + 1]) x++;
+        } else if (a > 0.0) {
+            x = -1;
+            while (x >= -4 && a * POTENCIAS_10[-x] < 1.0) x--;
+            if (x < -4) return nullptr;
+        }
+        if (x >= significativas) return nullptr;
+        decimales = significativas - 1 - x;
+    }
+    if (decimales < 0 || decimales > 9) return nullptr;
+    
+    uint64_t n = (uint64_t)nearbyint(a * POTENCIAS_10[decimales]);
+    if (general) {
+        // Si el redondeo sube una cifra (9.9999995 -> 10.0000) el exponente crece
+        if (a != 0.0 && n >= (uint64_t)POTENCIAS_10[max(cifras, 1)]) {
+            if (decimales == 0) return nullptr;
+            decimales--;
+            n /= 10;
+        }
+        while (decimales > 0 && n % 10 == 0) {
+            n /= 10;
+            decimales--;
+        }
+    }
+    
+    char digitos[24];
+    int largo = (int)(to_chars(digitos, digitos + sizeof(digitos), n).ptr - digitos);
+    if (signbit(valor)) *p++ = '-';
+    if (largo <= decimales) {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = largo; i < decimales; ++i) *p++ = '0';
+        memcpy(p, digitos, largo);
+        return p + largo;
+    }
+    memcpy(p, digitos, largo - decimales);
+    p += largo - decimales;
+    if (decimales > 0) {
+        *p++ = '.';
+        memcpy(p, digitos + largo - decimales, decimales);
+        p += decimales;
+    }
+    return p;
+}
+
+void salidaDecimal(SalidaLote& S, float valor, int decimales = 3) {
+    char num[64];
+    char* fin = decimalRapido(num, valor, decimales, false);
+    if (!fin) fin = to_chars(num, num + sizeof(num), (double)valor, chars_format::fixed, decimales).ptr;
+    salidaTexto(S, string_view(num, fin - num));
+}
+
+// Número alineado a la derecha en un campo de 'ancho' caracteres
+template <typename T>
+void salidaNumeroAncho(SalidaLote& S, T valor, int ancho) {
+    char num[32];
+    to_chars_result r = to_chars(num, num + sizeof(num), valor);
+    for (int i = (int)(r.ptr - num); i < ancho; ++i) salidaTexto(S, " ");
+    salidaTexto(S, string_view(num, r.ptr - num));
+}
+
+// Formato de decimales de un ostream (lo que usaría operator<<)
+struct EstiloDecimal {
+    chars_format formato;
+    int precision;
+    bool general;        // Sin fixed ni scientific: como printf("%g")
+};
+
+EstiloDecimal estiloDecimal(const ostream& o) {
+    ios::fmtflags campo = o.flags() & ios::floatfield;
+    EstiloDecimal e = {chars_format::general, (int)o.precision(), true};
+    if (campo == ios::fixed) e = {chars_format::fixed, (int)o.precision(), false};
+    else if (campo == ios::scientific) e = {chars_format::scientific, (int)o.precision(), false};
+    return e;
+}
+
+void salidaDecimal(SalidaLote& S, double valor, const EstiloDecimal& e) {
+    char num[400];   // fixed con DBL_MAX y precisión alta
+    to_chars_result r = to_chars(num, num + sizeof(num), valor, e.formato, min(e.precision, 64));
+    salidaTexto(S, string_view(num, r.ptr - num));
+}
+
+void salidaDecimal(SalidaLote& S, float valor, const EstiloDecimal& e) {
+    char num[400];
+    char* fin = e.formato == chars_format::scientific ? nullptr
+              : decimalRapido(num, valor, e.precision, e.general);
+    if (!fin) fin = to_chars(num, num + sizeof(num), (double)valor, e.formato, min(e.precision, 64)).ptr;
+    salidaTexto(S, string_view(num, fin - num));
+}
+
+// Nombres en CSV: entre comillas solo si tienen separadores o comillas ("" = comilla)
+void salidaCampoCSV(SalidaLote& S, const char* t) {
+    if (strpbrk(t, ",\"\r\n") == nullptr) {
+        salidaTexto(S, t);
+        return;
+    }
+    salidaTexto(S, "\"");
+    for (const char* p = t; *p; ++p) salidaTexto(S, *p == '"' ? string_view("\"\"") : string_view(p, 1));
+    salidaTexto(S, "\"");
+}
+
+// Cadena JSON con escapes (comillas, barra invertida y caracteres de control)
+void salidaCadenaJSON(SalidaLote& S, const char* t) {
+    static const char HEX[] = "0123456789abcdef";
+    salidaTexto(S, "\"");
+    for (const char* p = t; *p; ++p) {
+        unsigned char ch = (unsigned char)*p;
+        if (ch == '"' || ch == '\\') {
+            char esc[2] = {'\\', (char)ch};
+            salidaTexto(S, string_view(esc, 2));
+        } else if (ch < 0x20) {
+            char esc[6] = {'\\', 'u', '0', '0', HEX[ch >> 4], HEX[ch & 15]};
+            salidaTexto(S, string_view(esc, 6));
+        } else {
+            salidaTexto(S, string_view(p, 1));
+        }
+    }
+    salidaTexto(S, "\"");
+}
+
+// Reconoce un formato por nombre (en español para la línea de comandos, en inglés
+// para los comandos del modo por lotes)
+bool leerFormatoReporte(string_view t, FormatoReporte& formato) {
+    if (t == "texto" || t == "TEXT") formato = REPORTE_TEXTO;
+    else if (t == "tabla" || t == "TABLE") formato = REPORTE_TABLA;
+    else if (t == "csv" || t == "CSV") formato = REPORTE_CSV;
+    else if (t == "json" || t == "JSON") formato = REPORTE_JSON;
+    else return false;
+    return true;
+}
+
+// Encabezado de los formatos de máquina ('tipo' solo aparece en JSON)
+void reporteAbrir(SalidaLote& S, FormatoReporte formato, const char* tipo) {
+    if (formato == REPORTE_TABLA) {
+        salidaTexto(S, "  FILA   COL       ID   CANTIDAD    PESO(kg)  COMPONENTE\n");
+    } else if (formato == REPORTE_CSV) {
+        salidaTexto(S, "fila,columna,id,componente,peso,cantidad\n");
+    } else if (formato == REPORTE_JSON) {
+        salidaTexto(S, "{\"reporte\":\"");
+        salidaTexto(S, tipo);
+        salidaTexto(S, "\",\"lotes\":[");
+    }
+}
+
+void reporteCerrar(SalidaLote& S, FormatoReporte formato, int listados) {
+    if (formato == REPORTE_JSON) salidaTexto(S, listados ? "\n]}\n" : "]}\n");
+}
+
+// Un lote en un formato de máquina; 'listados' = lotes ya escritos en este reporte
+void reporteLote(SalidaLote& S, FormatoReporte formato, const Maestro& maestro, int slot, int f, int c,
+                 int listados) {
+    if (formato == REPORTE_TABLA) {
+        salidaNumeroAncho(S, f, 6);
+        salidaNumeroAncho(S, c, 6);
+        salidaNumeroAncho(S, maestroId(maestro, slot), 9);
+        salidaNumeroAncho(S, maestroCantidad(maestro, slot), 11);
+        char num[64];
+        char* fin = decimalRapido(num, maestroPeso(maestro, slot), 3, false);
+        if (!fin) fin = to_chars(num, num + sizeof(num), (double)maestroPeso(maestro, slot), chars_format::fixed, 3).ptr;
+        for (int i = (int)(fin - num); i < 12; ++i) salidaTexto(S, " ");
+        salidaTexto(S, string_view(num, fin - num));
+        salidaTexto(S, "  ");
+        salidaTexto(S, maestroNombre(maestro, slot));
+        salidaTexto(S, "\n");
+    } else if (formato == REPORTE_CSV) {
+        salidaNumero(S, f);
+        salidaTexto(S, ",");
+        salidaNumero(S, c);
+        salidaTexto(S, ",");
+        salidaNumero(S, maestroId(maestro, slot));
+        salidaTexto(S, ",");
+        salidaCampoCSV(S, maestroNombre(maestro, slot));
+        salidaTexto(S, ",");
+        salidaDecimal(S, maestroPeso(maestro, slot));
+        salidaTexto(S, ",");
+        salidaNumero(S, maestroCantidad(maestro, slot));
+        salidaTexto(S, "\n");
+    } else if (formato == REPORTE_JSON) {
+        salidaTexto(S, listados ? ",\n  {\"fila\":" : "\n  {\"fila\":");
+        salidaNumero(S, f);
+        salidaTexto(S, ",\"columna\":");
+        salidaNumero(S, c);
+        salidaTexto(S, ",\"id\":");
+        salidaNumero(S, maestroId(maestro, slot));
+        salidaTexto(S, ",\"componente\":");
+        salidaCadenaJSON(S, maestroNombre(maestro, slot));
+        salidaTexto(S, ",\"peso\":");
+        salidaDecimal(S, maestroPeso(maestro, slot));
+        salidaTexto(S, ",\"cantidad\":");
+        salidaNumero(S, maestroCantidad(maestro, slot));
+        salidaTexto(S, "}");
+    }
+}
+
+// Detalle de un lote en el reporte por fila (formato TEXTO)
+void textoPosicionFila(SalidaLote& S, const EstiloDecimal& e, const Maestro& maestro, int slot, int f, int c) {
+    salidaTexto(S, "Posición (");
+    salidaNumero(S, f);
+    salidaTexto(S, ", ");
+    salidaNumero(S, c);
+    salidaTexto(S, "): \n  ID: ");
+    salidaNumero(S, maestroId(maestro, slot));
+    salidaTexto(S, "\n  Componente: ");
+    salidaTexto(S, maestroNombre(maestro, slot));
+    salidaTexto(S, "\n  Peso unitario: ");
+    salidaDecimal(S, maestroPeso(maestro, slot), e);
+    salidaTexto(S, " kg\n  Cantidad: ");
+    salidaNumero(S, maestroCantidad(maestro, slot));
+    salidaTexto(S, " unidades\n");
+}
+
+// Reporte por fila (en filas anchas el formato TEXTO solo lista las posiciones ocupadas)
+// RETORNA: cantidad de lotes listados
+int reporteFila(const Almacen& A, const Maestro& maestro, int f, SalidaLote& S, FormatoReporte formato) {
+    if (f < 0 || f >= A.filas) return 0;
+    vector<int> celdas;
+    almacenOcupadas(A, f, f + 1, celdas);
+    
+    if (formato != REPORTE_TEXTO) {
+        reporteAbrir(S, formato, "fila");
+        for (size_t i = 0; i < celdas.size(); ++i) {
+            reporteLote(S, formato, maestro, almacenSlot(A, celdas[i]), f, celdas[i] % A.columnas, (int)i);
+        }
+        reporteCerrar(S, formato, (int)celdas.size());
+        return (int)celdas.size();
+    }
+    
+    EstiloDecimal e = estiloDecimal(cout);
+    salidaTexto(S, "=== REPORTE DE FILA ");
+    salidaNumero(S, f);
+    salidaTexto(S, " ===\nSubtotal: ");
+    salidaNumero(S, A.ocupadasFila[f]);
+    salidaTexto(S, " lotes, ");
+    salidaNumero(S, A.unidadesFila[f]);
+    salidaTexto(S, " unidades, ");
+    salidaDecimal(S, A.pesoFila[f], e);
+    salidaTexto(S, " kg\n");
+    
+    if (A.columnas <= MAX_DETALLE) {
+        for (int c = 0; c < A.columnas; ++c) {
+            int slot = almacenSlotFC(A, f, c);
+            if (slot == -1) {
+                salidaTexto(S, "Posición (");
+                salidaNumero(S, f);
+                salidaTexto(S, ", ");
+                salidaNumero(S, c);
+                salidaTexto(S, "): VACÍA\n");
+            } else {
+                textoPosicionFila(S, e, maestro, slot, f, c);
+            }
+        }
+        return (int)celdas.size();
+    }
+    
+    for (int idx : celdas) {
+        textoPosicionFila(S, e, maestro, almacenSlot(A, idx), f, idx % A.columnas);
+    }
+    salidaTexto(S, "Posiciones vacías en la fila: ");
+    salidaNumero(S, A.columnas - (int)celdas.size());
+    salidaTexto(S, "\n");
+    return (int)celdas.size();
+}
+
+void reporteFila(const Almacen& A, const Maestro& maestro, int f) {
+    SalidaLote S;
+    salidaInitFlujo(S, cout.rdbuf());
+    reporteFila(A, maestro, f, S, REPORTE_TEXTO);
+    salidaFree(S);
+}
+
+// Muestra los lotes de las celdas indicadas en orden de posición (fila, columna)
+void mostrarCoincidencias(const Almacen& A, const Maestro& maestro, vector<int>& celdas,
+                          SalidaLote& S, FormatoReporte formato) {
+    sort(celdas.begin(), celdas.end());
+    if (formato != REPORTE_TEXTO) {
+        for (size_t i = 0; i < celdas.size(); ++i) {
+            int idx = celdas[i];
+            reporteLote(S, formato, maestro, almacenSlot(A, idx), idx / A.columnas, idx % A.columnas, (int)i);
+        }
+        return;
+    }
+    
+    EstiloDecimal e = estiloDecimal(cout);
+    for (int idx : celdas) {
+        int slot = almacenSlot(A, idx);
+        salidaTexto(S, "Encontrado en posición (");
+        salidaNumero(S, idx / A.columnas);
+        salidaTexto(S, ", ");
+        salidaNumero(S, idx % A.columnas);
+        salidaTexto(S, ")\n  ID Lote: ");
+        salidaNumero(S, maestroId(maestro, slot));
+        salidaTexto(S, "\n  Componente: ");
+        salidaTexto(S, maestroNombre(maestro, slot));
+        salidaTexto(S, "\n  Cantidad: ");
+        salidaNumero(S, maestroCantidad(maestro, slot));
+        salidaTexto(S, " unidades\n  Peso unitario: ");
+        salidaDecimal(S, maestroPeso(maestro, slot), e);
+        salidaTexto(S, " kg\n");
+    }
+}
+
+// Buscar por nombre exacto en todo el almacén
+// COMPLEJIDAD: O(k log k) con k = lotes con ese nombre (no depende del área)
+// RETORNA: cantidad de lotes encontrados
+int buscarPorNombre(const Almacen& A, const Maestro& maestro, const char* nombre,
+                    SalidaLote& S, FormatoReporte formato) {
+    vector<int> celdas;
+    int nid = nombresBuscar(maestro.nombres, nombre);
+    if (nid != -1) celdasPorNombre(maestro, nid, celdas);
+    
+    if (formato != REPORTE_TEXTO) {
+        reporteAbrir(S, formato, "componente");
+        mostrarCoincidencias(A, maestro, celdas, S, formato);
+        reporteCerrar(S, formato, (int)celdas.size());
+        return (int)celdas.size();
+    }
+    
+    salidaTexto(S, "=== BÚSQUEDA POR COMPONENTE: ");
+    salidaTexto(S, nombre);
+    salidaTexto(S, " ===\n");
+    mostrarCoincidencias(A, maestro, celdas, S, formato);
+    if (nid != -1 && nid < (int)A.lotesComponente.size() && A.lotesComponente[nid] > 0) {
+        EstiloDecimal e = estiloDecimal(cout);
+        salidaTexto(S, "Total del componente: ");
+        salidaNumero(S, A.lotesComponente[nid]);
+        salidaTexto(S, " lotes, ");
+        salidaNumero(S, A.unidadesComponente[nid]);
+        salidaTexto(S, " unidades, ");
+        salidaDecimal(S, A.pesoComponente[nid], e);
+        salidaTexto(S, " kg\n");
+    }
+    return (int)celdas.size();
+}
+
+bool buscarPorNombre(const Almacen& A, const Maestro& maestro, const char* nombre) {
+    SalidaLote S;
+    salidaInitFlujo(S, cout.rdbuf());
+    int encontrados = buscarPorNombre(A, maestro, nombre, S, REPORTE_TEXTO);
+    salidaFree(S);
+    return encontrados > 0;
+}
+
+// Buscar todos los componentes cuyo nombre empieza con un prefijo (ej. "RES-")
+// COMPLEJIDAD: O(log nombres + nombres coincidentes + k log k), más ordenar los nombres
+// nuevos desde la búsqueda anterior (nombresOrdenar)
+bool buscarPorPrefijo(const Almacen& A, Maestro& maestro, const char* prefijo) {
+    SalidaLote S;
+    salidaInitFlujo(S, cout.rdbuf());
+    salidaTexto(S, "=== BÚSQUEDA POR PREFIJO: ");
+    salidaTexto(S, prefijo);
+    salidaTexto(S, " ===\n");
+    
+    nombresOrdenar(maestro.nombres);
+    const TablaNombres& t = maestro.nombres;
+    size_t largo = strlen(prefijo);
+    
+    // Primer nombre >= prefijo; los que coinciden son contiguos a partir de ahí
+    const int* pos = lower_bound(t.orden, t.orden + t.n, prefijo, [&t](int a, const char* p) {
+        return strcmp(nombreTexto(t, a), p) < 0;
+    });
+    
+    vector<int> celdas;
+    for (; pos != t.orden + t.n && strncmp(nombreTexto(t, *pos), prefijo, largo) == 0; ++pos) {
+        celdasPorNombre(maestro, *pos, celdas);
+    }
+    mostrarCoincidencias(A, maestro, celdas, S, REPORTE_TEXTO);
+    salidaFree(S);
+    return !celdas.empty();
+}
+
+// Una posición ocupada del reporte completo (formato TEXTO)
+void textoPosicionCompleta(SalidaLote& S, const EstiloDecimal& e, const Maestro& maestro, int slot, int f, int c) {
+    salidaTexto(S, "Pos (");
+    salidaNumero(S, f);
+    salidaTexto(S, ",");
+    salidaNumero(S, c);
+    salidaTexto(S, "): ID:");
+    salidaNumero(S, maestroId(maestro, slot));
+    salidaTexto(S, " | ");
+    salidaTexto(S, maestroNombre(maestro, slot));
+    salidaTexto(S, " | ");
+    salidaNumero(S, maestroCantidad(maestro, slot));
+    salidaTexto(S, " uds | ");
+    salidaDecimal(S, maestroPeso(maestro, slot), e);
+    salidaTexto(S, " kg/ud\n");
+}
+
+// Reporte completo del almacén (en almacenes grandes el formato TEXTO solo muestra las
+// filas y posiciones ocupadas; los formatos de máquina nunca listan posiciones vacías)
+// RETORNA: cantidad de lotes listados
+int reporteCompleto(const Almacen& A, const Maestro& maestro, SalidaLote& S, FormatoReporte formato) {
+    vector<int> celdas;
+    almacenOcupadas(A, 0, A.filas, celdas);
+    
+    if (formato != REPORTE_TEXTO) {
+        reporteAbrir(S, formato, "completo");
+        for (size_t i = 0; i < celdas.size(); ++i) {
+            int idx = celdas[i];
+            reporteLote(S, formato, maestro, almacenSlot(A, idx), idx / A.columnas, idx % A.columnas, (int)i);
+        }
+        reporteCerrar(S, formato, (int)celdas.size());
+        return (int)celdas.size();
+    }
+    
+    EstiloDecimal e = estiloDecimal(cout);
+    salidaTexto(S, "\n=== REPORTE COMPLETO DEL ALMACÉN ===\n");
+    
+    if (A.filas <= MAX_DETALLE && A.columnas <= MAX_DETALLE) {
+        for (int f = 0; f < A.filas; ++f) {
+            salidaTexto(S, "\n--- FILA ");
+            salidaNumero(S, f);
+            salidaTexto(S, " ---\n");
+            for (int c = 0; c < A.columnas; ++c) {
+                int slot = almacenSlotFC(A, f, c);
+                if (slot == -1) {
+                    salidaTexto(S, "Pos (");
+                    salidaNumero(S, f);
+                    salidaTexto(S, ",");
+                    salidaNumero(S, c);
+                    salidaTexto(S, "): VACÍA\n");
+                } else {
+                    textoPosicionCompleta(S, e, maestro, slot, f, c);
+                }
+            }
+        }
+        return (int)celdas.size();
+    }
+    
+    // Almacén grande: recorrer solo las celdas ocupadas, agrupadas por fila
+    int filaActual = -1;
+    for (int idx : celdas) {
+        int f = idx / A.columnas;
+        if (f != filaActual) {
+            salidaTexto(S, "\n--- FILA ");
+            salidaNumero(S, f);
+            salidaTexto(S, " ---\n");
+            filaActual = f;
+        }
+        textoPosicionCompleta(S, e, maestro, almacenSlot(A, idx), f, idx % A.columnas);
+    }
+    return (int)celdas.size();
+}
+
+void reporteCompleto(const Almacen& A, const Maestro& maestro) {
+    SalidaLote S;
+    salidaInitFlujo(S, cout.rdbuf());
+    reporteCompleto(A, maestro, S, REPORTE_TEXTO);
+    salidaFree(S);
+}
+
+/*======================================================================================
+BITÁCORA DE INSPECCIONES EN DISCO
+======================================================================================
+Todas las inspecciones se agregan a inspecciones_almacen.log, un archivo mapeado en
+memoria con registros de tamaño fijo (lote, resultado, componente, marca de tiempo):
+  [CabeceraBitacora][RegistroInspeccion x capacidad]
+- cabecera.n es la cantidad de registros confirmados; se actualiza solo después de
+  sincronizar los registros, así un corte nunca deja registros a medio escribir
+- El archivo crece al doble (ftruncate + nuevo mapeo) cuando se llena
+- Deshacer retira el último registro (la pila en memoria es una ventana de la cola)
+COMPONENTES: el registro guarda la posición del nombre en un archivo aparte
+(<bitácora>.nombres: cabecera + un nombre de NOMBRE_MAX bytes por componente, solo se
+agrega). Un nombre nuevo se confirma en disco antes que los registros que lo usan, y al
+abrir se interna en una TablaNombres en orden de archivo, así su nombreId coincide con
+la posición y la búsqueda por nombre compara el texto (dos nombres con el mismo hash no
+se mezclan). Los registros de la versión 1 solo tenían un hash de 32 bits: al abrir un
+archivo viejo se convierten a la versión 2 sin componente (cuentan para el lote y la
+tasa global, no para ningún componente).
+ÍNDICES EN MEMORIA (se construyen con un recorrido al abrir):
+- Por lote y por componente: posiciones de sus registros en orden cronológico
+- Aprobadas dentro de la ventana móvil de las últimas VENTANA_INSPECCIONES
+COMPLEJIDAD: registrar, deshacer y consultar una tasa son O(1) (amortizado)
+======================================================================================*/
+const char BITACORA_MAGIA[8] = {'A', 'L', 'P', 'H', 'I', 'N', 'S', 'P'};
+const uint32_t BITACORA_VERSION = 2;
+const char* const ARCHIVO_INSPECCIONES = "inspecciones_almacen.log";
+const char COMPONENTES_MAGIA[8] = {'A', 'L', 'P', 'H', 'C', 'O', 'M', 'P'};
+const uint32_t COMPONENTE_DESCONOCIDO = 0xFFFFFFFFu;  // Registros convertidos de la versión 1
+const int VENTANA_INSPECCIONES = 1000;   // Tamaño de la ventana móvil de tasas
+const size_t BITACORA_CAP_INICIAL = 4096;
+
+struct CabeceraBitacora {
+    char magia[8];         // "ALPHINSP"
+    uint32_t version;      // BITACORA_VERSION
+    uint32_t tamRegistro;  // sizeof(RegistroInspeccion)
+    uint64_t n;            // Registros confirmados
+};
+
+struct RegistroInspeccion {
+    int32_t idLote;
+    int32_t resultado;     // 1=aprobado, 0=rechazado
+    uint32_t componente;   // Posición del nombre en el archivo de componentes
+    uint32_t reservado;
+    int64_t marcaTiempo;   // Milisegundos desde epoch
+};
+
+// Inspecciones de un lote o de un componente
+struct SerieInspecciones {
+    vector<uint32_t> posiciones;  // Índice: registros de la serie en orden cronológico
+    int aprobadasVentana;         // Aprobadas entre las últimas VENTANA_INSPECCIONES
+    long long aprobadasTotal;
+};
+
+struct BitacoraInspecciones {
+    char* datos;           // Cabecera + registros (archivo mapeado)
+    size_t capacidad;      // Registros que caben en 'datos'
+    size_t n;              // Registros vigentes
+    size_t pendiente;      // Primer registro modificado desde la última confirmación
+    int fd;                // Descriptor del archivo (-1 sin mmap)
+    string ruta;           // Archivo de la bitácora (sin mmap se reescribe al sincronizar)
+    IndiceID indiceLote;   // idLote -> posición en 'lotes'
+    TablaNombres nombres;  // Componentes; nombreId = posición en el archivo de nombres
+    FILE* archivoNombres;  // <bitácora>.nombres, abierto para agregar
+    string rutaNombres;
+    int nombresConfirmados;  // Nombres ya confirmados en disco
+    vector<SerieInspecciones> lotes;
+    vector<SerieInspecciones> componentes;  // Por nombreId
+    SerieInspecciones global;
+};
+
+// Fuerza los datos de un archivo abierto al disco
+// RETORNA: false si no se pudieron vaciar los buffers o confirmar en disco
+bool sincronizarArchivo(FILE* archivo) {
+    bool ok = (fflush(archivo) == 0);
+#ifdef ALPHATECH_MMAP
+    ok = (fsync(fileno(archivo)) == 0) && ok;
+#endif
+    return ok;
+}
+
+// Confirma en disco las entradas del directorio que contiene 'ruta' (tras un rename,
+// que sin esto puede perderse en un corte aunque el archivo ya esté confirmado)
+bool sincronizarDirectorio(const char* ruta) {
+#ifdef ALPHATECH_MMAP
+    string directorio(ruta);
+    size_t barra = directorio.find_last_of('/');
+    directorio = (barra == string::npos) ? string(".") : directorio.substr(0, barra + 1);
+    int fd = open(directorio.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    bool ok = (fsync(fd) == 0);
+    close(fd);
+    return ok;
+#else
+    (void)ruta;
+    return true;
+#endif
+}
+
+inline RegistroInspeccion* bitacoraRegistro(const BitacoraInspecciones& B, size_t pos) {
+    return (RegistroInspeccion*)(B.datos + sizeof(CabeceraBitacora)) + pos;
+}
+
+inline CabeceraBitacora* bitacoraCabecera(const BitacoraInspecciones& B) {
+    return (CabeceraBitacora*)B.datos;
+}
+
+// Serie de un lote o componente (nullptr si no tiene inspecciones)
+const SerieInspecciones* bitacoraSerieLote(const BitacoraInspecciones& B, int idLote) {
+    int i = indiceBuscar(B.indiceLote, idLote);
+    return i == -1 ? nullptr : &B.lotes[i];
+}
+
+const SerieInspecciones* bitacoraSerieComponente(const BitacoraInspecciones& B, const char* nombre) {
+    int nid = nombresBuscar(B.nombres, nombre);
+    return nid == -1 ? nullptr : &B.componentes[nid];
+}
+
+// Serie del componente de un registro (nullptr si es un registro sin componente)
+inline SerieInspecciones* bitacoraSerieRegistro(BitacoraInspecciones& B, const RegistroInspeccion* r) {
+    return r->componente < B.componentes.size() ? &B.componentes[r->componente] : nullptr;
+}
+
+// Busca o crea la serie asociada a una clave
+SerieInspecciones& serieObtener(IndiceID& indice, vector<SerieInspecciones>& series, int clave) {
+    int i = indiceBuscar(indice, clave);
+    if (i == -1) {
+        i = (int)series.size();
+        series.push_back(SerieInspecciones{vector<uint32_t>(), 0, 0});
+        indiceInsertar(indice, clave, i);
+    }
+    return series[i];
+}
+
+// Agrega el registro 'pos' al final de la serie y desliza la ventana
+void serieAgregar(const BitacoraInspecciones& B, SerieInspecciones& s, uint32_t pos) {
+    s.posiciones.push_back(pos);
+    if (bitacoraRegistro(B, pos)->resultado) {
+        s.aprobadasVentana++;
+        s.aprobadasTotal++;
+    }
+    size_t tam = s.posiciones.size();
+    if (tam > (size_t)VENTANA_INSPECCIONES
+        && bitacoraRegistro(B, s.posiciones[tam - 1 - VENTANA_INSPECCIONES])->resultado) {
+        s.aprobadasVentana--;  // Sale de la ventana
+    }
+}
+
+// Retira el último registro de la serie (deshacer) y devuelve a la ventana el que había salido
+void serieRetirar(const BitacoraInspecciones& B, SerieInspecciones& s) {
+    if (bitacoraRegistro(B, s.posiciones.back())->resultado) {
+        s.aprobadasVentana--;
+        s.aprobadasTotal--;
+    }
+    s.posiciones.pop_back();
+    size_t tam = s.posiciones.size();
+    if (tam >= (size_t)VENTANA_INSPECCIONES
+        && bitacoraRegistro(B, s.posiciones[tam - VENTANA_INSPECCIONES])->resultado) {
+        s.aprobadasVentana++;  // Vuelve a la ventana
+    }
+}
+
+// Inspecciones dentro de la ventana y tasa de aprobación (%) de una serie
+int serieVentana(const SerieInspecciones& s) {
+    return (int)min(s.posiciones.size(), (size_t)VENTANA_INSPECCIONES);
+}
+
+float serieTasaAprobacion(const SerieInspecciones& s) {
+    int n = serieVentana(s);
+    return n == 0 ? 0.0f : 100.0f * s.aprobadasVentana / n;
+}
+
+// Indexa el registro 'pos' en las series de su lote, su componente y la global
+void bitacoraIndexar(BitacoraInspecciones& B, uint32_t pos) {
+    const RegistroInspeccion* r = bitacoraRegistro(B, pos);
+    serieAgregar(B, serieObtener(B.indiceLote, B.lotes, r->idLote), pos);
+    SerieInspecciones* componente = bitacoraSerieRegistro(B, r);
+    if (componente) serieAgregar(B, *componente, pos);
+    serieAgregar(B, B.global, pos);
+}
+
+// Ajusta el tamaño del archivo y el mapeo para 'capacidad' registros
+bool bitacoraMapear(BitacoraInspecciones& B, size_t capacidad) {
+    size_t tamNuevo = sizeof(CabeceraBitacora) + capacidad * sizeof(RegistroInspeccion);
+#ifdef ALPHATECH_MMAP
+    if (ftruncate(B.fd, (off_t)tamNuevo) != 0) return false;
+    void* datos = mmap(nullptr, tamNuevo, PROT_READ | PROT_WRITE, MAP_SHARED, B.fd, 0);
+    if (datos == MAP_FAILED) return false;
+    if (B.datos) munmap(B.datos, sizeof(CabeceraBitacora) + B.capacidad * sizeof(RegistroInspeccion));
+    B.datos = (char*)datos;
+#else
+    // Sin mmap: búfer en memoria; bitacoraSincronizar escribe el archivo
+    char* datos = new char[tamNuevo];
+    memset(datos, 0, tamNuevo);
+    if (B.datos) {
+        memcpy(datos, B.datos, sizeof(CabeceraBitacora) + B.n * sizeof(RegistroInspeccion));
+        delete[] B.datos;
+    }
+    B.datos = datos;
+#endif
+    B.capacidad = capacidad;
+    return true;
+}
+
+// Lee el archivo de nombres de componentes (o lo crea) y los interna en orden, así el
+// nombreId de cada uno es su posición. Un nombre cortado al final (corte durante la
+// escritura) se descarta reescribiendo el archivo solo con los completos
+bool bitacoraAbrirNombres(BitacoraInspecciones& B) {
+    vector<char> datos;
+    ifstream previo(B.rutaNombres, ios::binary);
+    if (previo.is_open()) datos.assign(istreambuf_iterator<char>(previo), istreambuf_iterator<char>());
+    previo.close();
+    const size_t cab = sizeof(COMPONENTES_MAGIA);
+    bool valido = datos.size() >= cab && memcmp(datos.data(), COMPONENTES_MAGIA, cab) == 0;
+    if (!datos.empty() && !valido) return false;
+    
+    size_t completos = valido ? (datos.size() - cab) / NOMBRE_MAX : 0;
+    for (size_t i = 0; i < completos; ++i) {
+        char nombre[NOMBRE_MAX];
+        memcpy(nombre, datos.data() + cab + i * NOMBRE_MAX, NOMBRE_MAX);
+        nombre[NOMBRE_MAX - 1] = '\0';
+        if (nombresInternar(B.nombres, nombre) != (int)i) return false;  // Repetido: dañado
+    }
+    
+    if (!valido || datos.size() != cab + completos * NOMBRE_MAX) {
+        string temporal = B.rutaNombres + ".tmp";
+        FILE* archivo = fopen(temporal.c_str(), "wb");
+        if (!archivo) return false;
+        bool ok = fwrite(COMPONENTES_MAGIA, cab, 1, archivo) == 1
+               && (completos == 0 || fwrite(datos.data() + cab, NOMBRE_MAX, completos, archivo) == completos);
+        ok = sincronizarArchivo(archivo) && ok;
+        fclose(archivo);
+        if (!ok || rename(temporal.c_str(), B.rutaNombres.c_str()) != 0
+            || !sincronizarDirectorio(B.rutaNombres.c_str())) return false;
+    }
+    B.archivoNombres = fopen(B.rutaNombres.c_str(), "ab");
+    B.nombresConfirmados = B.nombres.n;
+    B.componentes.assign(B.nombres.n, SerieInspecciones{vector<uint32_t>(), 0, 0});
+    return B.archivoNombres != nullptr;
+}
+
+// nombreId del componente en la bitácora; uno nuevo se agrega al archivo de nombres
+// (se confirma en disco con bitacoraSincronizar, antes que los registros)
+// RETORNA: -1 si no se pudo escribir
+int bitacoraComponente(BitacoraInspecciones& B, const char* componente) {
+    char nombre[NOMBRE_MAX];
+    memset(nombre, 0, sizeof(nombre));
+    strncpy(nombre, componente, NOMBRE_MAX - 1);
+    int nid = nombresBuscar(B.nombres, nombre);
+    if (nid != -1) return nid;
+    if (!B.archivoNombres || fwrite(nombre, NOMBRE_MAX, 1, B.archivoNombres) != 1) return -1;
+    B.componentes.push_back(SerieInspecciones{vector<uint32_t>(), 0, 0});
+    return nombresInternar(B.nombres, nombre);
+}
+
+bool bitacoraSincronizar(BitacoraInspecciones& B);
+
+// Abre (o crea) la bitácora y reconstruye los índices con un solo recorrido
+bool bitacoraAbrir(BitacoraInspecciones& B, const char* nombreArchivo) {
+    B.datos = nullptr;
+    B.capacidad = B.n = B.pendiente = 0;
+    B.fd = -1;
+    B.ruta = nombreArchivo;
+    indiceInit(B.indiceLote);
+    nombresInit(B.nombres);
+    B.archivoNombres = nullptr;
+    B.rutaNombres = string(nombreArchivo) + ".nombres";
+    B.nombresConfirmados = 0;
+    B.global = SerieInspecciones{vector<uint32_t>(), 0, 0};
+    
+    // Paso 1: Tamaño actual del archivo (0 si no existe)
+    size_t tam = 0;
+#ifdef ALPHATECH_MMAP
+    B.fd = open(nombreArchivo, O_RDWR | O_CREAT, 0644);
+    if (B.fd < 0) return false;
+    struct stat info;
+    if (fstat(B.fd, &info) == 0) tam = (size_t)info.st_size;
+#else
+    ifstream previo(nombreArchivo, ios::binary | ios::ate);
+    if (previo.is_open()) tam = (size_t)previo.tellg();
+#endif
+    
+    // Paso 2: Validar la cabecera existente o inicializar una nueva
+    CabeceraBitacora cab;
+    memset(&cab, 0, sizeof(cab));
+    bool existe = false;
+    if (tam >= sizeof(cab)) {
+#ifdef ALPHATECH_MMAP
+        existe = pread(B.fd, &cab, sizeof(cab), 0) == (ssize_t)sizeof(cab);
+#else
+        previo.seekg(0);
+        existe = (bool)previo.read((char*)&cab, sizeof(cab));
+#endif
+        existe = existe && memcmp(cab.magia, BITACORA_MAGIA, sizeof(cab.magia)) == 0
+              && (cab.version == BITACORA_VERSION || cab.version == 1)
+              && cab.tamRegistro == sizeof(RegistroInspeccion)
+              && sizeof(cab) + cab.n * sizeof(RegistroInspeccion) <= tam;
+    }
+    size_t capacidad = existe ? (tam - sizeof(cab)) / sizeof(RegistroInspeccion) : BITACORA_CAP_INICIAL;
+    // Un archivo existente pero inválido no se sobrescribe
+    if ((tam > 0 && !existe) || !bitacoraAbrirNombres(B)
+        || !bitacoraMapear(B, max(capacidad, BITACORA_CAP_INICIAL))) {
+        cout << "✗ Bitácora de inspecciones inválida o inaccesible: " << nombreArchivo << endl;
+#ifdef ALPHATECH_MMAP
+        close(B.fd);
+        B.fd = -1;
+#endif
+        if (B.archivoNombres) fclose(B.archivoNombres);
+        B.archivoNombres = nullptr;
+        return false;
+    }
+#ifndef ALPHATECH_MMAP
+    if (existe) {
+        previo.seekg(0);
+        previo.read(B.datos, sizeof(cab) + cab.n * sizeof(RegistroInspeccion));
+    }
+#endif
+    if (!existe) {
+        memcpy(cab.magia, BITACORA_MAGIA, sizeof(cab.magia));
+        cab.version = BITACORA_VERSION;
+        cab.tamRegistro = sizeof(RegistroInspeccion);
+        memcpy(B.datos, &cab, sizeof(cab));
+#ifdef ALPHATECH_MMAP
+        msync(B.datos, sizeof(cab), MS_SYNC);
+#endif
+    }
+    
+    // Paso 3: Convertir la versión 1 (componente = hash, sin nombre recuperable)
+    B.n = B.pendiente = (size_t)cab.n;
+    if (existe && cab.version == 1) {
+        for (size_t i = 0; i < B.n; ++i) bitacoraRegistro(B, i)->componente = COMPONENTE_DESCONOCIDO;
+        bitacoraCabecera(B)->version = BITACORA_VERSION;
+#ifdef ALPHATECH_MMAP
+        msync(B.datos, sizeof(CabeceraBitacora) + B.n * sizeof(RegistroInspeccion), MS_SYNC);
+#else
+        B.pendiente = 0;  // Reescribir el archivo completo al sincronizar
+        bitacoraSincronizar(B);
+#endif
+        cout << "⚠ Bitácora de versión 1 convertida: sus " << B.n
+             << " inspecciones anteriores quedan sin componente" << endl;
+    }
+    
+    // Paso 4: Índices por lote, por componente y global
+    for (size_t i = 0; i < B.n; ++i) bitacoraIndexar(B, (uint32_t)i);
+    return true;
+}
+
+// Confirma en disco los nombres nuevos, los registros desde 'pendiente' (un deshacer
+// seguido de una inspección reescribe un registro ya confirmado) y después el contador
+// de la cabecera
+bool bitacoraSincronizar(BitacoraInspecciones& B) {
+    if (!B.datos || (B.pendiente >= B.n && bitacoraCabecera(B)->n == B.n)) return true;
+    if (B.nombresConfirmados < B.nombres.n) {
+        if (!sincronizarArchivo(B.archivoNombres)) return false;
+        B.nombresConfirmados = B.nombres.n;
+    }
+    size_t desde = min(B.pendiente, B.n);
+#ifdef ALPHATECH_MMAP
+    // Paso 1: Registros (solo las páginas modificadas desde la última confirmación)
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    size_t ini = (sizeof(CabeceraBitacora) + desde * sizeof(RegistroInspeccion)) / pagina * pagina;
+    size_t fin = sizeof(CabeceraBitacora) + B.n * sizeof(RegistroInspeccion);
+    if (fin > ini && msync(B.datos + ini, fin - ini, MS_SYNC) != 0) return false;
+    // Paso 2: Cabecera
+    bitacoraCabecera(B)->n = B.n;
+    if (msync(B.datos, sizeof(CabeceraBitacora), MS_SYNC) != 0) return false;
+#else
+    // La cabecera en memoria conserva el contador confirmado hasta que el archivo lo tenga
+    FILE* archivo = fopen(B.ruta.c_str(), "r+b");
+    if (!archivo) archivo = fopen(B.ruta.c_str(), "wb");  // Todavía no existe
+    if (!archivo) return false;
+    CabeceraBitacora cab = *bitacoraCabecera(B);
+    bool ok = true;
+    // Paso 1: Si se reescriben registros ya confirmados, la cabecera baja antes, así un
+    // corte nunca deja contado un registro a medio reescribir
+    if (cab.n > desde && desde < B.n) {
+        cab.n = desde;
+        ok = fwrite(&cab, sizeof(cab), 1, archivo) == 1 && sincronizarArchivo(archivo);
+    }
+    // Paso 2: Registros
+    size_t ini = sizeof(CabeceraBitacora) + desde * sizeof(RegistroInspeccion);
+    ok = ok && fseek(archivo, (long)ini, SEEK_SET) == 0
+         && fwrite(B.datos + ini, sizeof(RegistroInspeccion), B.n - desde, archivo) == B.n - desde
+         && sincronizarArchivo(archivo);
+    // Paso 3: Cabecera
+    cab.n = B.n;
+    ok = ok && fseek(archivo, 0, SEEK_SET) == 0 && fwrite(&cab, sizeof(cab), 1, archivo) == 1
+         && sincronizarArchivo(archivo);
+    ok = (fclose(archivo) == 0) && ok;
+    if (!ok) return false;
+    bitacoraCabecera(B)->n = B.n;
+#endif
+    B.pendiente = B.n;
+    return true;
+}
+
+void bitacoraCerrar(BitacoraInspecciones& B) {
+    bitacoraSincronizar(B);
+#ifdef ALPHATECH_MMAP
+    if (B.datos) munmap(B.datos, sizeof(CabeceraBitacora) + B.capacidad * sizeof(RegistroInspeccion));
+    if (B.fd >= 0) close(B.fd);
+#else
+    delete[] B.datos;
+#endif
+    B.datos = nullptr;
+    B.fd = -1;
+    indiceFree(B.indiceLote);
+    if (B.archivoNombres) fclose(B.archivoNombres);
+    B.archivoNombres = nullptr;
+    nombresFree(B.nombres);
+    B.lotes.clear();
+    B.componentes.clear();
+    B.global.posiciones.clear();
+}
+
+// Agrega una inspección al final de la bitácora
+// COMPLEJIDAD: O(1) amortizado (el archivo crece al doble al llenarse)
+bool bitacoraRegistrar(BitacoraInspecciones& B, int idLote, int resultado, const char* componente) {
+    if (!B.datos) return false;
+    if (B.n == B.capacidad && !bitacoraMapear(B, B.capacidad * 2)) {
+        cout << "✗ Error: No se pudo ampliar la bitácora de inspecciones" << endl;
+        return false;
+    }
+    int nid = bitacoraComponente(B, componente);
+    if (nid == -1) {
+        cout << "✗ Error: No se pudo registrar el componente en la bitácora" << endl;
+        return false;
+    }
+#ifdef ALPHATECH_MMAP
+    // Reescribe un registro ya confirmado (tras deshacer): la cabecera baja primero en
+    // disco, porque la página del registro puede llegar al disco antes de sincronizar
+    if (B.n < bitacoraCabecera(B)->n) {
+        bitacoraCabecera(B)->n = B.n;
+        if (msync(B.datos, sizeof(CabeceraBitacora), MS_SYNC) != 0) return false;
+    }
+#endif
+    B.pendiente = min(B.pendiente, B.n);
+    RegistroInspeccion* r = bitacoraRegistro(B, B.n);
+    r->idLote = idLote;
+    r->resultado = resultado;
+    r->componente = (uint32_t)nid;
+    r->reservado = 0;
+    r->marcaTiempo = chrono::duration_cast<chrono::milliseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+    bitacoraIndexar(B, (uint32_t)B.n);
+    B.n++;
+    return true;
+}
+
+// Retira la última inspección (deshacer)
+// COMPLEJIDAD: O(1)
+bool bitacoraDeshacer(BitacoraInspecciones& B) {
+    if (!B.datos || B.n == 0) return false;
+    const RegistroInspeccion* r = bitacoraRegistro(B, B.n - 1);
+    serieRetirar(B, B.lotes[indiceBuscar(B.indiceLote, r->idLote)]);
+    SerieInspecciones* componente = bitacoraSerieRegistro(B, r);
+    if (componente) serieRetirar(B, *componente);
+    serieRetirar(B, B.global);
+    B.n--;
+    B.pendiente = min(B.pendiente, B.n);
+    return true;
+}
+
+// Muestra la tasa móvil de aprobación de una serie
+void mostrarTasa(const char* etiqueta, const SerieInspecciones* s) {
+    cout << etiqueta;
+    if (!s || s->posiciones.empty()) {
+        cout << "sin inspecciones" << endl;
+        return;
+    }
+    cout << fixed << setprecision(1) << serieTasaAprobacion(*s) << "% aprobado en las últimas "
+         << serieVentana(*s) << " inspecciones (" << s->posiciones.size() << " en total)" << endl;
+}
+
+/*======================================================================================
+SISTEMA DE PILA PARA HISTORIAL DE INSPECCIONES
+======================================================================================
+Anillo de tamaño potencia de 2 con capacidad configurable (por defecto 10). Push y pop
+son O(1); con la pila llena, el push sobrescribe la inspección más antigua en lugar de
+desplazar los elementos. La pila es una ventana en memoria sobre la cola de la bitácora
+de inspecciones: al iniciar se llena con sus últimos registros.
+CONCURRENCIA: un solo escritor (la estación que hace push/pop) y cualquier número de
+lectores sin bloqueo. Cada modificación incrementa 'version' dos veces (impar = en
+curso); un lector copia el contenido y reintenta si la versión cambió (seqlock). Sin
+barreras sueltas: el escritor guarda los datos con release (no pueden adelantarse a la
+versión impar) y el lector los carga con acquire (no pueden atrasarse a la relectura
+de la versión); en x86 son los mismos mov y ThreadSanitizer los entiende.
+======================================================================================*/
+const int PILA_CAPACIDAD = 10;  // Inspecciones que se conservan en memoria
+
+struct Pila {
+    atomic<int>* id;        // IDs de lotes inspeccionados (anillo)
+    atomic<int>* res;       // Resultados: 1=aprobado, 0=rechazado
+    int capacidad;          // Máximo de inspecciones vigentes
+    int mascara;            // Tamaño del anillo - 1 (potencia de 2)
+    atomic<long long> cabeza;   // Posición del próximo push (crece sin envolver)
+    atomic<int> cuenta;         // Inspecciones vigentes (0..capacidad)
+    atomic<unsigned> version;   // Contador del seqlock para los lectores
+};
+
+// Inicializa la pila vacía con la capacidad indicada
+void pilaInit(Pila& p, int capacidad = PILA_CAPACIDAD) {
+    int tam = 1;
+    while (tam < capacidad) tam <<= 1;
+    p.id = new atomic<int>[tam];
+    p.res = new atomic<int>[tam];
+    p.capacidad = capacidad;
+    p.mascara = tam - 1;
+    p.cabeza.store(0, memory_order_relaxed);
+    p.cuenta.store(0, memory_order_relaxed);
+    p.version.store(0, memory_order_relaxed);
+}
+
+void pilaFree(Pila& p) {
+    delete[] p.id;
+    delete[] p.res;
+    p.id = p.res = nullptr;
+}
+
+// Verifica si la pila está vacía
+bool pilaVacia(const Pila& p) { 
+    return p.cuenta.load(memory_order_relaxed) == 0; 
+}
+
+// Inicio y fin de una modificación (solo el escritor); entre ambos, los datos se
+// guardan con memory_order_release
+void pilaEscrituraInicio(Pila& p) {
+    p.version.store(p.version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+void pilaEscrituraFin(Pila& p) {
+    p.version.store(p.version.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+// Agrega una inspección a la pila
+// COMPLEJIDAD: O(1); con la pila llena se descarta la más antigua
+void pilaPush(Pila& p, int idLote, int resultado) {
+    METRICA_TIEMPO(MET_PILA_PUSH);
+    long long cabeza = p.cabeza.load(memory_order_relaxed);
+    int cuenta = p.cuenta.load(memory_order_relaxed);
+    pilaEscrituraInicio(p);
+    p.id[cabeza & p.mascara].store(idLote, memory_order_release);
+    p.res[cabeza & p.mascara].store(resultado, memory_order_release);
+    p.cabeza.store(cabeza + 1, memory_order_release);
+    if (cuenta < p.capacidad) p.cuenta.store(cuenta + 1, memory_order_release);
+    pilaEscrituraFin(p);
+}
+
+// Remueve la última inspección de la pila
+bool pilaPop(Pila& p, int& idLote, int& resultado) {
+    METRICA_TIEMPO(MET_PILA_POP);
+    if (pilaVacia(p)) return false;
+    long long cabeza = p.cabeza.load(memory_order_relaxed) - 1;
+    idLote = p.id[cabeza & p.mascara].load(memory_order_relaxed);
+    resultado = p.res[cabeza & p.mascara].load(memory_order_relaxed);
+    pilaEscrituraInicio(p);
+    p.cabeza.store(cabeza, memory_order_release);
+    p.cuenta.store(p.cuenta.load(memory_order_relaxed) - 1, memory_order_release);
+    pilaEscrituraFin(p);
+    return true;
+}
+
+// Vacía la pila conservando su capacidad
+void pilaVaciar(Pila& p) {
+    pilaEscrituraInicio(p);
+    p.cuenta.store(0, memory_order_release);
+    pilaEscrituraFin(p);
+}
+
+// Copia consistente del contenido, de la más antigua a la más reciente
+// Seguro desde cualquier hilo mientras el escritor sigue operando
+void pilaCopiar(const Pila& p, vector<int>& ids, vector<int>& res) {
+    unsigned v1, v2;
+    do {
+        v1 = p.version.load(memory_order_acquire);
+        if (v1 & 1) {
+            this_thread::yield();  // Escritura en curso
+            continue;
+        }
+        long long cabeza = p.cabeza.load(memory_order_acquire);
+        int cuenta = p.cuenta.load(memory_order_acquire);
+        ids.resize(cuenta);
+        res.resize(cuenta);
+        for (int i = 0; i < cuenta; ++i) {
+            long long pos = cabeza - cuenta + i;
+            ids[i] = p.id[pos & p.mascara].load(memory_order_acquire);
+            res[i] = p.res[pos & p.mascara].load(memory_order_acquire);
+        }
+        v2 = p.version.load(memory_order_relaxed);
+    } while ((v1 & 1) || v1 != v2);
+}
+
+// Mostrar todo el historial de inspecciones
+void mostrarHistorialInspecciones(const Pila& p, const Maestro& maestro, const BitacoraInspecciones& B) {
+    cout << "\n=== HISTORIAL COMPLETO DE INSPECCIONES ===" << endl;
+    
+    // Copia consistente (no bloquea a las estaciones que registran inspecciones)
+    vector<int> ids, resultados;
+    pilaCopiar(p, ids, resultados);
+    int n = (int)ids.size();
+    if (n == 0) {
+        cout << "No hay inspecciones registradas." << endl;
+        return;
+    }
+    
+    cout << "Total de inspecciones: " << n << endl;
+    cout << "----------------------------------------" << endl;
+    
+    // Mostrar desde la más reciente hasta la más antigua
+    for (int i = n - 1; i >= 0; i--) {
+        cout << "Inspección " << (n - i) << ":" << endl;
+        cout << "  ID Lote: " << ids[i] << endl;
+        
+        // Buscar información del lote en el maestro
+        int idx = maestroBuscarID(maestro, ids[i]);
+        if (idx != -1) {
+            cout << "  Componente: " << maestroNombre(maestro, idx) << endl;
+            cout << "  Cantidad: " << maestroCantidad(maestro, idx) << " unidades" << endl;
+        } else {
+            cout << "  Componente: [Lote eliminado]" << endl;
+        }
+        
+        cout << "  Resultado: " << (resultados[i] ? "APROBADO" : "RECHAZADO") << endl;
+        mostrarTasa("  Tasa del lote: ", bitacoraSerieLote(B, ids[i]));
+        cout << "----------------------------------------" << endl;
+    }
+    
+    // Estadísticas: ventana móvil de la bitácora (O(1)); sin bitácora, la pila en memoria
+    int aprobados = 0, rechazados = 0;
+    if (!B.global.posiciones.empty()) {
+        aprobados = B.global.aprobadasVentana;
+        rechazados = serieVentana(B.global) - aprobados;
+    } else {
+        for (int i = 0; i < n; i++) {
+            if (resultados[i] == 1) aprobados++;
+            else rechazados++;
+        }
+    }
+    
+    cout << "\nESTADÍSTICAS DEL HISTORIAL (últimas " << (aprobados + rechazados) << " inspecciones):" << endl;
+    cout << "Lotes aprobados: " << aprobados << endl;
+    cout << "Lotes rechazados: " << rechazados << endl;
+    
+    if (rechazados > 0) {
+        float porcentajeRechazo = (float)rechazados / (aprobados + rechazados) * 100.0f;
+        cout << "Tasa de rechazo: " << fixed << setprecision(1) << porcentajeRechazo << "%" << endl;
+        
+        if (porcentajeRechazo > 20.0f) {
+            cout << "ALERTA: Alta tasa de rechazo!" << endl;
+        }
+    }
+}
+
+/*======================================================================================
+SISTEMA DE EXPORTACIÓN/IMPORTACIÓN Y BACKUP DE DATOS
+======================================================================================
+Estas funciones permiten:
+- Exportar el estado completo del almacén a un archivo de texto
+- Importar datos previamente guardados
+- Crear backups automáticos del sistema
+- Restaurar desde backups
+======================================================================================*/
+
+// Exporta todos los datos del almacén a un archivo de texto
+bool exportarDatos(const Almacen& A, const Maestro& maestro, const char* nombreArchivo) {
+    METRICA_TIEMPO(MET_EXPORTAR);
+    SalidaLote S;  // Búfer de 64 KB del motor de reportes: sin vaciar en cada línea
+    if (!salidaAbrirArchivo(S, nombreArchivo)) {
+        cout << "✗ Error: No se pudo crear el archivo " << nombreArchivo << endl;
+        return false;
+    }
+    
+    cout << "Exportando datos del almacén..." << endl;
+    
+    // Escribir encabezado con metadatos
+    salidaTexto(S, "# BACKUP ALMACEN ALPHATECH\n");
+    salidaTexto(S, "# Generado automáticamente\n");
+    salidaTexto(S, "DIMENSIONES=");
+    salidaNumero(S, A.filas);
+    salidaTexto(S, ",");
+    salidaNumero(S, A.columnas);
+    salidaTexto(S, "\nTOTAL_LOTES=");
+    salidaNumero(S, maestro.size);
+    salidaTexto(S, "\n# Formato: FILA,COLUMNA,ID,NOMBRE,PESO,CANTIDAD\n");
+    
+    // Exportar todos los lotes con sus posiciones (solo se recorren las ocupadas)
+    // El nombre va sin comillas: es el formato que lee importarDatos
+    int lotesExportados = 0;
+    vector<int> celdas;
+    almacenOcupadas(A, 0, A.filas, celdas);
+    for (int idx : celdas) {
+        int slot = almacenSlot(A, idx);
+        salidaNumero(S, idx / A.columnas);
+        salidaTexto(S, ",");
+        salidaNumero(S, idx % A.columnas);
+        salidaTexto(S, ",");
+        salidaNumero(S, maestroId(maestro, slot));
+        salidaTexto(S, ",");
+        salidaTexto(S, maestroNombre(maestro, slot));
+        salidaTexto(S, ",");
+        salidaDecimal(S, maestroPeso(maestro, slot));
+        salidaTexto(S, ",");
+        salidaNumero(S, maestroCantidad(maestro, slot));
+        salidaTexto(S, "\n");
+        lotesExportados++;
+    }
+    
+    if (!salidaCerrarArchivo(S)) {
+        cout << "✗ Error: No se pudo escribir el archivo " << nombreArchivo << endl;
+        return false;
+    }
+    cout << "✓ Datos exportados exitosamente: " << lotesExportados << " lotes guardados en " << nombreArchivo << endl;
+    return true;
+}
+
+// Mapea un archivo completo en memoria de solo lectura (mmap o lectura completa)
+// RETORNA: puntero a los datos (nullptr si falla); liberar con liberarMapeo
+const char* mapearArchivo(const char* nombreArchivo, size_t& tam) {
+#ifdef ALPHATECH_MMAP
+    int fd = open(nombreArchivo, O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    tam = (size_t)info.st_size;
+    void* datos = mmap(nullptr, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // El mapeo sigue siendo válido tras cerrar el descriptor
+    if (datos == MAP_FAILED) return nullptr;
+    madvise(datos, tam, MADV_SEQUENTIAL);
+    return (const char*)datos;
+#else
+    ifstream archivo(nombreArchivo, ios::binary | ios::ate);
+    if (!archivo.is_open()) return nullptr;
+    tam = (size_t)archivo.tellg();
+    char* datos = new char[tam];
+    archivo.seekg(0);
+    archivo.read(datos, tam);
+    if (!archivo) {
+        delete[] datos;
+        return nullptr;
+    }
+    return datos;
+#endif
+}
+
+// Libera un archivo mapeado con mapearArchivo
+void liberarMapeo(const char* datos, size_t tam) {
+#ifdef ALPHATECH_MMAP
+    munmap((void*)datos, tam);
+#else
+    (void)tam;
+    delete[] datos;
+#endif
+}
+
+/*======================================================================================
+LECTOR CSV POR BLOQUES (SIN ASIGNACIONES POR LÍNEA)
+======================================================================================
+- El archivo se lee en bloques grandes sobre un único búfer reutilizable
+- Cada línea se entrega como string_view apuntando al búfer (sin copias)
+- Los números se convierten con from_chars (sin excepciones ni strings temporales)
+La memoria usada es constante: solo crece si aparece una línea más larga que el búfer.
+Cada lectura toma lo que ya esté disponible (hasta el tamaño del bloque) y solo espera
+si no hay nada, así una entrada interactiva (tubería, FIFO) recibe respuesta a cada
+línea. Antes de esperar más entrada se entregan las respuestas acumuladas en 'salida'.
+Los archivos grandes se mapean en memoria y se analizan por trozos en varios hilos;
+la combinación en el maestro y el almacén también es paralela y da el mismo resultado
+que la importación secuencial (ver COMBINACIÓN PARALELA DE UN CSV ANALIZADO).
+======================================================================================*/
+const size_t TAM_BLOQUE_LECTURA = 1 << 20;  // 1 MB por lectura
+
+struct LectorLineas {
+    istream* archivo;   // Archivo (o entrada estándar) de origen
+    int fd;             // Descriptor leído con read() en lugar de 'archivo' (-1 = no)
+    SalidaLote* salida; // Se entrega antes de cada lectura (nullptr = ninguna)
+    char* buf;          // Búfer de lectura
+    size_t cap;         // Capacidad del búfer
+    size_t ini;         // Inicio de los datos pendientes
+    size_t fin;         // Fin de los datos válidos
+    bool eof;           // Ya no hay más datos en el archivo
+    int numLinea;       // Número de la última línea entregada (desde 1)
+};
+
+void lectorInit(LectorLineas& L, istream& archivo) {
+    L.archivo = &archivo;
+    L.fd = -1;
+    L.salida = nullptr;
+    L.cap = TAM_BLOQUE_LECTURA;
+    L.buf = new char[L.cap];
+    L.ini = L.fin = 0;
+    L.eof = false;
+    L.numLinea = 0;
+}
+
+void lectorFree(LectorLineas& L) {
+    delete[] L.buf;
+    L.buf = nullptr;
+}
+
+// Lee lo que ya esté disponible (hasta 'espacio' bytes), esperando solo si no hay nada
+// RETORNA: bytes leídos (0 al terminar el archivo, y marca eof)
+size_t lectorRellenar(LectorLineas& L, char* destino, size_t espacio) {
+#ifdef ALPHATECH_MMAP
+    if (L.fd >= 0) {
+        ssize_t leidos;
+        do {
+            leidos = read(L.fd, destino, espacio);
+        } while (leidos < 0 && errno == EINTR);
+        if (leidos <= 0) L.eof = true;
+        return leidos > 0 ? (size_t)leidos : 0;
+    }
+#endif
+    size_t leidos = (size_t)L.archivo->readsome(destino, (streamsize)espacio);
+    if (leidos > 0) return leidos;
+    int ch = L.archivo->get();  // Nada en el búfer del flujo: esperar un carácter
+    if (ch == char_traits<char>::eof()) {
+        L.eof = true;
+        return 0;
+    }
+    destino[0] = (char)ch;
+    return 1 + (size_t)L.archivo->readsome(destino + 1, (streamsize)espacio - 1);
+}
+
+// Entrega la siguiente línea (sin '\n' ni '\r' final); false al terminar el archivo
+bool leerLinea(LectorLineas& L, string_view& linea) {
+    while (true) {
+        // ¿Hay una línea completa en los datos pendientes?
+        const char* p = L.buf + L.ini;
+        const char* nl = (const char*)memchr(p, '\n', L.fin - L.ini);
+        if (nl || (L.eof && L.ini < L.fin)) {
+            size_t largo = nl ? (size_t)(nl - p) : L.fin - L.ini;
+            L.ini += largo + (nl ? 1 : 0);
+            if (largo > 0 && p[largo - 1] == '\r') largo--;
+            linea = string_view(p, largo);
+            L.numLinea++;
+            return true;
+        }
+        if (L.eof) return false;
+        
+        // Mover el resto al inicio y rellenar (duplicar si una línea no cabe)
+        size_t resto = L.fin - L.ini;
+        if (resto == L.cap) {
+            char* nb = new char[L.cap * 2];
+            memcpy(nb, L.buf + L.ini, resto);
+            delete[] L.buf;
+            L.buf = nb;
+            L.cap *= 2;
+        } else {
+            memmove(L.buf, L.buf + L.ini, resto);
+        }
+        L.ini = 0;
+        L.fin = resto;
+        if (L.salida) salidaEntregar(*L.salida);
+        L.fin += lectorRellenar(L, L.buf + L.fin, L.cap - L.fin);
+    }
+}
+
+// Quita espacios al inicio y al final
+inline string_view recortar(string_view t) {
+    while (!t.empty() && (t.front() == ' ' || t.front() == '\t')) t.remove_prefix(1);
+    while (!t.empty() && (t.back() == ' ' || t.back() == '\t')) t.remove_suffix(1);
+    return t;
+}
+
+// Convierte un campo completo a número (false si sobra texto o no es válido)
+template <typename T>
+bool leerNumero(string_view t, T& valor) {
+    t = recortar(t);
+    if (t.empty()) return false;
+    const char* fin = t.data() + t.size();
+    from_chars_result r = from_chars(t.data(), fin, valor);
+    return r.ec == errc() && r.ptr == fin;
+}
+
+// Separa una fila FILA,COLUMNA,ID,NOMBRE,PESO,CANTIDAD en sus 6 campos
+// El nombre es todo lo que queda entre el tercer campo y los dos últimos,
+// así un nombre con comas no desplaza los campos numéricos
+bool separarFila(string_view linea, string_view campos[6]) {
+    for (int i = 0; i < 3; ++i) {
+        size_t coma = linea.find(',');
+        if (coma == string_view::npos) return false;
+        campos[i] = linea.substr(0, coma);
+        linea.remove_prefix(coma + 1);
+    }
+    for (int i = 5; i >= 4; --i) {
+        size_t coma = linea.rfind(',');
+        if (coma == string_view::npos) return false;
+        campos[i] = linea.substr(coma + 1);
+        linea = linea.substr(0, coma);
+    }
+    campos[3] = linea;
+    return true;
+}
+
+// Resultado de analizar una línea del CSV
+const int CSV_VACIA = 0;        // Línea vacía, comentario u otro metadato
+const int CSV_DIMENSIONES = 1;  // DIMENSIONES=F,C
+const int CSV_TOTAL = 2;        // TOTAL_LOTES=N
+const int CSV_LOTE = 3;         // FILA,COLUMNA,ID,NOMBRE,PESO,CANTIDAD
+const int CSV_ERROR = 4;        // Línea mal formada
+
+const int MAX_ERRORES_MOSTRADOS = 20;             // Errores listados en consola por importación
+const size_t UMBRAL_IMPORTACION_PARALELA = 8 << 20;  // Archivos desde 8 MB se importan en paralelo
+const int MAX_HILOS_IMPORTACION = 8;
+
+struct FilaCSV {
+    int tipo;          // CSV_*
+    int linea;         // Número de línea en el archivo
+    int f, c, id;      // Posición e ID (CSV_LOTE) o filas/columnas en f/c (CSV_DIMENSIONES)
+    int cantidad;      // Cantidad (CSV_LOTE) o total (CSV_TOTAL)
+    float peso;
+    string_view nombre;  // Apunta al texto original (búfer o archivo mapeado)
+};
+
+// Analiza una línea sin copiarla ni asignar memoria
+void analizarLineaCSV(string_view linea, FilaCSV& fila) {
+    linea = recortar(linea);
+    fila.tipo = CSV_VACIA;
+    if (linea.empty() || linea[0] == '#') return;  // Vacías y comentarios
+    
+    // Metadatos: dimensiones y total de lotes
+    if (linea.substr(0, 12) == "DIMENSIONES=") {
+        string_view resto = linea.substr(12);
+        size_t coma = resto.find(',');
+        fila.tipo = (coma != string_view::npos
+                     && leerNumero(resto.substr(0, coma), fila.f)
+                     && leerNumero(resto.substr(coma + 1), fila.c)
+                     && fila.f >= 1 && fila.f <= MAX_DIMENSION
+                     && fila.c >= 1 && fila.c <= MAX_DIMENSION) ? CSV_DIMENSIONES : CSV_ERROR;
+        return;
+    }
+    if (linea.substr(0, 12) == "TOTAL_LOTES=") {
+        if (leerNumero(linea.substr(12), fila.cantidad) && fila.cantidad > 0) fila.tipo = CSV_TOTAL;
+        return;
+    }
+    if (linea.find('=') != string_view::npos) return;  // Otros metadatos
+    
+    // Línea de datos: FILA,COLUMNA,ID,NOMBRE,PESO,CANTIDAD
+    string_view campos[6];
+    bool ok = separarFila(linea, campos)
+           && leerNumero(campos[0], fila.f) && leerNumero(campos[1], fila.c) && leerNumero(campos[2], fila.id)
+           && leerNumero(campos[4], fila.peso) && leerNumero(campos[5], fila.cantidad);
+    fila.nombre = recortar(campos[3]);
+    fila.tipo = ok ? CSV_LOTE : CSV_ERROR;
+}
+
+// Contadores de una importación (la consola solo recibe un resumen)
+struct ResumenImportacion {
+    int importados;
+    int errores;
+};
+
+// Registra un error de importación (solo se muestran los primeros)
+void errorImportacion(ResumenImportacion& r, int linea, const char* motivo, int id = 0) {
+    if (r.errores < MAX_ERRORES_MOSTRADOS) {
+        cout << "✗ Línea " << linea << ": " << motivo;
+        if (id) cout << " (lote " << id << ")";
+        cout << endl;
+    } else if (r.errores == MAX_ERRORES_MOSTRADOS) {
+        cout << "✗ ... (más errores omitidos)" << endl;
+    }
+    r.errores++;
+}
+
+// Copia el nombre de una fila a un búfer fijo (sin strings temporales), recortado a
+// NOMBRE_MAX - 1 caracteres como en LoteProduccion
+inline void nombreFilaCSV(const FilaCSV& fila, char nombre[NOMBRE_MAX]) {
+    size_t largo = min(fila.nombre.size(), (size_t)NOMBRE_MAX - 1);
+    memcpy(nombre, fila.nombre.data(), largo);
+    nombre[largo] = '\0';
+}
+
+// Aplica una línea ya analizada sobre el almacén y el maestro
+// Se llama siempre en orden de archivo, así duplicados y colisiones se resuelven
+// igual sin importar cómo se haya dividido el trabajo (gana la primera aparición)
+void aplicarFilaCSV(Almacen*& A, Maestro& maestro, const FilaCSV& fila, ResumenImportacion& r) {
+    switch (fila.tipo) {
+        case CSV_DIMENSIONES:
+            if (A == nullptr) {
+                A = crearAlmacen(fila.f, fila.c);
+                cout << "Almacén recreado: " << A->filas << "x" << A->columnas << endl;
+            }
+            return;
+        case CSV_TOTAL:
+            maestroReservarCapacidad(maestro, fila.cantidad);
+            return;
+        case CSV_ERROR:
+            errorImportacion(r, fila.linea, "fila mal formada, se omite");
+            return;
+        case CSV_LOTE:
+            break;
+        default:
+            return;
+    }
+    if (A == nullptr) {
+        errorImportacion(r, fila.linea, "lote antes de DIMENSIONES, se omite", fila.id);
+        return;
+    }
+    
+    // Crear lote y colocarlo
+    char nombre[NOMBRE_MAX];
+    nombreFilaCSV(fila, nombre);
+    int slot = maestroCrear(maestro, fila.id, nombre, fila.peso, fila.cantidad);
+    if (slot == -1) {
+        errorImportacion(r, fila.linea, "ID duplicado, se omite", fila.id);
+    } else if (colocar(*A, maestro, fila.f, fila.c, slot)) {
+        r.importados++;
+    } else {
+        maestroEliminar(maestro, fila.id);  // No dejar lotes huérfanos en el maestro
+        errorImportacion(r, fila.linea, "posición inválida u ocupada", fila.id);
+    }
+}
+
+// Importación secuencial por bloques (memoria constante)
+void importarSecuencial(ifstream& archivo, Almacen*& A, Maestro& maestro, ResumenImportacion& r) {
+    LectorLineas L;
+    lectorInit(L, archivo);
+    string_view linea;
+    FilaCSV fila;
+    while (leerLinea(L, linea)) {
+        analizarLineaCSV(linea, fila);
+        fila.linea = L.numLinea;
+        aplicarFilaCSV(A, maestro, fila, r);
+    }
+    lectorFree(L);
+}
+
+// Trabajo de un hilo: analiza las líneas de [ini, fin) y guarda las que importan
+// Los números de línea quedan relativos al trozo; se corrigen al combinar
+void analizarTrozoCSV(const char* ini, const char* fin, vector<FilaCSV>* filas, int* lineas) {
+    int n = 0;
+    FilaCSV fila;
+    while (ini < fin) {
+        const char* nl = (const char*)memchr(ini, '\n', fin - ini);
+        const char* finLinea = nl ? nl : fin;
+        string_view linea(ini, finLinea - ini);
+        if (!linea.empty() && linea.back() == '\r') linea.remove_suffix(1);
+        
+        analizarLineaCSV(linea, fila);
+        fila.linea = ++n;
+        if (fila.tipo != CSV_VACIA) filas->push_back(fila);
+        ini = nl ? nl + 1 : fin;
+    }
+    *lineas = n;
+}
+
+// Ejecuta trabajo(p) para p = 0..partes-1, cada parte en su propio hilo (la 0 en este)
+template <typename Trabajo>
+void enParalelo(int partes, Trabajo trabajo) {
+    vector<thread> hilos;
+    for (int p = 1; p < partes; ++p) hilos.emplace_back(trabajo, p);
+    trabajo(0);
+    for (thread& h : hilos) h.join();
+}
+
+/*======================================================================================
+COMBINACIÓN PARALELA DE UN CSV ANALIZADO
+======================================================================================
+El resultado es idéntico al de aplicar las filas una por una en orden de archivo: una
+fila de lote se importa si ninguna fila ANTERIOR importada tiene su ID o su celda (las
+que fallan no retienen nada), es decir, gana la primera aparición. Eso se decide en
+pasadas por partición, sin estructuras compartidas:
+- Grupos de ID: filas con el mismo ID, repartidas por hash del ID
+- Grupos de celda: filas con la misma celda, repartidas por rangos de filas del almacén
+En cada ronda, detrás de una ganadora las pendientes de su grupo pierden, y una
+pendiente que es la primera viva de sus dos grupos gana. La pendiente más temprana
+siempre se decide, y sin cadenas de conflictos basta una ronda; tras
+RONDAS_COMBINACION rondas lo que quede se decide con un recorrido en orden.
+Después, con las ganadoras ya conocidas:
+- Los nombres se internan por particiones de hash y se numeran en orden de aparición
+- Sumas prefijas por rango de filas dan a cada ganadora su puesto y su slot
+- Los bloques del maestro (de a MAESTRO_BLOQUE slots) se llenan en paralelo, y cada
+  partición de filas coloca sus lotes (celdas, ocupación y subtotales de sus filas)
+- Un hilo aparte lleva lo que depende del orden: índice de IDs, listas por nombre y
+  totales (la suma de Kahan del peso da los mismos bits que la secuencial)
+======================================================================================*/
+const char LOTE_PENDIENTE = 0;     // Depende de filas anteriores sin decidir
+const char LOTE_GANA = 1;          // Se importa
+const char LOTE_PIERDE = 2;        // Posición inválida u ocupada (o ID duplicado, ver abajo)
+const char LOTE_DUPLICADO = 3;     // ID del maestro o de una fila ganadora anterior
+const char LOTE_SIN_ALMACEN = 4;   // Lote antes de DIMENSIONES
+const char LOTE_NINGUNO = 5;       // No es una fila de lote
+const int RONDAS_COMBINACION = 4;  // Rondas en paralelo antes de seguir en orden
+
+struct CombinacionCSV {
+    int partes;                          // Particiones (una por hilo)
+    const Almacen* A;                    // Almacén destino (nullptr si no hay DIMENSIONES)
+    vector<const FilaCSV*> filas;        // Filas con contenido, en orden de archivo
+    vector<char> estado;                 // LOTE_* de cada fila
+    vector<char> parteID;                // Partición del ID de cada fila de lote
+    vector<char> parteFila;              // Rango de filas del almacén de cada fila de lote
+    vector<int> lotesParte;              // Filas de lote de cada partición de ID
+    vector<int> sigID;                   // Siguiente fila del mismo grupo de ID (-1)
+    vector<int> sigCelda;                // Siguiente fila del mismo grupo de celda (-1)
+    vector<char> libreID;                // Primera viva de su grupo de ID en esta ronda
+    vector<char> libreCelda;             // Primera viva de su grupo de celda en esta ronda
+    vector<vector<int>> gruposID;        // Primera fila de cada grupo de ID, por partición
+    vector<vector<int>> gruposCelda;     // Primera fila de cada grupo de celda, por partición
+    vector<vector<int>> filasParticion;  // Filas pendientes de cada rango de filas, en orden
+    vector<char> parteNombre;            // Partición del nombre (filas que lo internan)
+    vector<int> nid;                     // nombreId: local de su partición, luego global
+    vector<int> slot;                    // Slot del maestro de cada fila ganadora
+    vector<int> ganadoras;               // Filas ganadoras en orden de archivo
+};
+
+// Partición de un valor con hash h: usa los bits altos (las tablas locales, los bajos)
+inline int particionHash(unsigned h, int partes) {
+    return (int)(((uint64_t)h * (unsigned)partes) >> 32);
+}
+
+inline int particionID(int id, int partes) {
+    return particionHash((unsigned)id * 2654435769u, partes);
+}
+
+// Rango de filas del almacén al que pertenece la fila f
+inline int particionFila(const Almacen& A, int f, int partes) {
+    return (int)((long long)f * partes / A.filas);
+}
+
+// Rango [ini, fin) de la parte p al repartir n elementos (alineado a 'alinear')
+inline void rangoParte(int n, int partes, int p, int& ini, int& fin, int alinear = 1) {
+    ini = min(n, (int)((long long)n * p / partes / alinear * alinear));
+    fin = (p + 1 == partes) ? n : min(n, (int)((long long)n * (p + 1) / partes / alinear * alinear));
+}
+
+// Filas que internan su nombre (las que fallan por posición también lo hacen)
+inline bool loteConNombre(char estado) {
+    return estado == LOTE_GANA || estado == LOTE_PIERDE;
+}
+
+// Tabla local para unas n claves (capacidad potencia de 2, carga <= 1/2: no crece)
+void indiceInitPara(IndiceID& ix, int n) {
+    int cap = 16;
+    while (cap < 2 * (n + 1)) cap *= 2;
+    indiceInit(ix, cap);
+}
+
+// Une la fila g a su grupo (clave -> índice del grupo en 'ultima')
+void combinarAgrupar(IndiceID& grupos, vector<int>& ultima, vector<int>& cabezas, vector<int>& sig,
+                     int clave, int g) {
+    int grupo = indiceBuscar(grupos, clave);
+    if (grupo == -1) {
+        indiceInsertar(grupos, clave, (int)ultima.size());
+        cabezas.push_back(g);
+        ultima.push_back(g);
+    } else {
+        sig[ultima[grupo]] = g;
+        ultima[grupo] = g;
+    }
+}
+
+// Grupos de ID de la partición p y estado inicial de sus filas: antes de DIMENSIONES,
+// ID ya en el maestro, posición fuera del almacén o ya ocupada
+void combinarGruposID(CombinacionCSV& K, const Maestro& maestro, int desde, int p) {
+    IndiceID grupos;
+    indiceInitPara(grupos, K.lotesParte[p]);
+    vector<int> ultima;
+    for (int g = 0; g < (int)K.filas.size(); ++g) {
+        if (K.parteID[g] != p) continue;
+        const FilaCSV& fila = *K.filas[g];
+        if (g < desde) {
+            K.estado[g] = LOTE_SIN_ALMACEN;
+            continue;
+        }
+        // Un maestro o un almacén vacíos (lo normal) no se consultan
+        if (maestro.size > 0 && indiceBuscar(maestro.indice, fila.id) != -1) K.estado[g] = LOTE_DUPLICADO;
+        else if (!almacenDentro(*K.A, fila.f, fila.c)) K.estado[g] = LOTE_PIERDE;
+        else if (K.A->ocupadas > 0 && almacenOcupadaFC(*K.A, fila.f, fila.c)) K.estado[g] = LOTE_PIERDE;
+        else K.estado[g] = LOTE_PENDIENTE;
+        if (K.estado[g] == LOTE_PENDIENTE) K.parteFila[g] = (char)particionFila(*K.A, fila.f, K.partes);
+        combinarAgrupar(grupos, ultima, K.gruposID[p], K.sigID, fila.id, g);
+    }
+    indiceFree(grupos);
+}
+
+// Grupos de celda del rango de filas p (solo las filas que siguen pendientes)
+void combinarGruposCelda(CombinacionCSV& K, int p) {
+    int n = (int)K.filas.size();
+    for (int g = 0; g < n; ++g) {
+        if (K.parteFila[g] == p) K.filasParticion[p].push_back(g);
+    }
+    IndiceID grupos;
+    indiceInitPara(grupos, (int)K.filasParticion[p].size());
+    vector<int> ultima;
+    for (int g : K.filasParticion[p]) {
+        const FilaCSV& fila = *K.filas[g];
+        combinarAgrupar(grupos, ultima, K.gruposCelda[p], K.sigCelda, fila.f * K.A->columnas + fila.c, g);
+    }
+    indiceFree(grupos);
+}
+
+// Una ronda sobre un grupo: detrás de una ganadora las pendientes pierden; sin ganadora,
+// la primera pendiente queda libre en este grupo y las siguientes esperan
+void combinarGrupo(CombinacionCSV& K, int g, const vector<int>& sig, vector<char>& libre, char pierde) {
+    bool tomado = false;
+    for (; g != -1; g = sig[g]) {
+        if (K.estado[g] == LOTE_GANA) {
+            tomado = true;
+        } else if (K.estado[g] == LOTE_PENDIENTE) {
+            if (!tomado) {
+                libre[g] = 1;
+                return;
+            }
+            K.estado[g] = pierde;
+        }
+    }
+}
+
+// Gana la pendiente libre en sus dos grupos
+// RETORNA: filas del rango [ini, fin) que siguen pendientes
+int combinarDecidir(CombinacionCSV& K, int ini, int fin) {
+    int pendientes = 0;
+    for (int g = ini; g < fin; ++g) {
+        if (K.estado[g] != LOTE_PENDIENTE) continue;
+        if (K.libreID[g] && K.libreCelda[g]) K.estado[g] = LOTE_GANA;
+        else pendientes++;
+        K.libreID[g] = K.libreCelda[g] = 0;
+    }
+    return pendientes;
+}
+
+// Decide las pendientes que quedan recorriendo las filas en orden de archivo
+void combinarEnOrden(CombinacionCSV& K) {
+    IndiceID ids, celdas;
+    indiceInit(ids);
+    indiceInit(celdas);
+    for (int g = 0; g < (int)K.filas.size(); ++g) {
+        if (K.estado[g] != LOTE_GANA && K.estado[g] != LOTE_PENDIENTE) continue;
+        const FilaCSV& fila = *K.filas[g];
+        int idx = fila.f * K.A->columnas + fila.c;
+        if (K.estado[g] == LOTE_PENDIENTE) {
+            if (indiceBuscar(ids, fila.id) != -1) K.estado[g] = LOTE_DUPLICADO;
+            else if (indiceBuscar(celdas, idx) != -1) K.estado[g] = LOTE_PIERDE;
+            else K.estado[g] = LOTE_GANA;
+            if (K.estado[g] != LOTE_GANA) continue;
+        }
+        indiceInsertar(ids, fila.id, g);
+        indiceInsertar(celdas, idx, g);
+    }
+    indiceFree(ids);
+    indiceFree(celdas);
+}
+
+// Una fila que perdió detrás de una ganadora con su mismo ID es un ID duplicado (la
+// secuencial mira el ID antes que la celda), aunque haya perdido por la celda
+void combinarMotivos(CombinacionCSV& K, int p) {
+    for (int g : K.gruposID[p]) {
+        bool tomado = false;
+        for (; g != -1; g = K.sigID[g]) {
+            if (K.estado[g] == LOTE_GANA) tomado = true;
+            else if (K.estado[g] == LOTE_PIERDE && tomado) K.estado[g] = LOTE_DUPLICADO;
+        }
+    }
+}
+
+// Decide qué filas de lote se importan (ver el bloque de arriba)
+void combinarResolver(CombinacionCSV& K, const Maestro& maestro, int desde) {
+    int n = (int)K.filas.size();
+    K.estado.assign(n, LOTE_NINGUNO);
+    K.parteID.assign(n, -1);
+    K.parteFila.assign(n, -1);
+    K.lotesParte.assign(K.partes, 0);
+    K.sigID.assign(n, -1);
+    K.sigCelda.assign(n, -1);
+    K.libreID.assign(n, 0);
+    K.libreCelda.assign(n, 0);
+    K.gruposID.assign(K.partes, vector<int>());
+    K.gruposCelda.assign(K.partes, vector<int>());
+    K.filasParticion.assign(K.partes, vector<int>());
+    vector<vector<int>> lotes(K.partes, vector<int>(K.partes, 0));
+    enParalelo(K.partes, [&](int p) {
+        int ini, fin;
+        rangoParte(n, K.partes, p, ini, fin);
+        for (int g = ini; g < fin; ++g) {
+            if (K.filas[g]->tipo != CSV_LOTE) continue;
+            K.parteID[g] = (char)particionID(K.filas[g]->id, K.partes);
+            lotes[p][K.parteID[g]]++;
+        }
+    });
+    for (int p = 0; p < K.partes; ++p) {
+        for (int q = 0; q < K.partes; ++q) K.lotesParte[q] += lotes[p][q];
+    }
+    enParalelo(K.partes, [&](int p) { combinarGruposID(K, maestro, desde, p); });
+    if (K.A == nullptr) return;  // Ningún lote tiene dónde ir
+    enParalelo(K.partes, [&](int p) { combinarGruposCelda(K, p); });
+    
+    vector<int> pendientes(K.partes, 1);
+    for (int ronda = 0; ronda < RONDAS_COMBINACION; ++ronda) {
+        enParalelo(K.partes, [&](int p) {
+            for (int g : K.gruposID[p]) combinarGrupo(K, g, K.sigID, K.libreID, LOTE_DUPLICADO);
+        });
+        enParalelo(K.partes, [&](int p) {
+            for (int g : K.gruposCelda[p]) combinarGrupo(K, g, K.sigCelda, K.libreCelda, LOTE_PIERDE);
+        });
+        enParalelo(K.partes, [&](int p) {
+            int ini, fin;
+            rangoParte(n, K.partes, p, ini, fin);
+            pendientes[p] = combinarDecidir(K, ini, fin);
+        });
+        if (count(pendientes.begin(), pendientes.end(), 0) == K.partes) break;
+    }
+    if (count(pendientes.begin(), pendientes.end(), 0) != K.partes) combinarEnOrden(K);
+    enParalelo(K.partes, [&](int p) { combinarMotivos(K, p); });
+}
+
+// Interna los nombres de las filas que lo hacen, en el orden de la secuencial
+// ALGORITMO: cada partición de hash interna los suyos en una tabla local y anota qué
+// fila introdujo cada nombre; esas filas, en orden de archivo, dan el orden global
+void combinarNombres(CombinacionCSV& K, TablaNombres& nombres) {
+    int n = (int)K.filas.size();
+    K.parteNombre.assign(n, -1);
+    K.nid.assign(n, -1);
+    enParalelo(K.partes, [&](int p) {
+        int ini, fin;
+        rangoParte(n, K.partes, p, ini, fin);
+        char nombre[NOMBRE_MAX];
+        for (int g = ini; g < fin; ++g) {
+            if (!loteConNombre(K.estado[g])) continue;
+            nombreFilaCSV(*K.filas[g], nombre);
+            K.parteNombre[g] = (char)particionHash(nombreHash(nombre), K.partes);
+        }
+    });
+    
+    vector<vector<int>> primeras(K.partes);  // Fila que introdujo cada nombre local
+    enParalelo(K.partes, [&](int p) {
+        TablaNombres local;
+        nombresInit(local);
+        char nombre[NOMBRE_MAX];
+        for (int g = 0; g < n; ++g) {
+            if (K.parteNombre[g] != p) continue;
+            nombreFilaCSV(*K.filas[g], nombre);
+            K.nid[g] = nombresInternar(local, nombre);
+            if (K.nid[g] == (int)primeras[p].size()) primeras[p].push_back(g);
+        }
+        nombresFree(local);
+    });
+    
+    // Nombres nuevos en orden de primera aparición; local -> global por partición
+    vector<int> orden;
+    for (const vector<int>& v : primeras) orden.insert(orden.end(), v.begin(), v.end());
+    sort(orden.begin(), orden.end());
+    vector<vector<int>> global(K.partes);
+    for (int p = 0; p < K.partes; ++p) global[p].resize(primeras[p].size());
+    char nombre[NOMBRE_MAX];
+    for (int g : orden) {
+        nombreFilaCSV(*K.filas[g], nombre);
+        global[K.parteNombre[g]][K.nid[g]] = nombresInternar(nombres, nombre);
+    }
+    enParalelo(K.partes, [&](int p) {
+        int ini, fin;
+        rangoParte(n, K.partes, p, ini, fin);
+        for (int g = ini; g < fin; ++g) {
+            if (K.parteNombre[g] != -1) K.nid[g] = global[K.parteNombre[g]][K.nid[g]];
+        }
+    });
+}
+
+// Puesto de cada ganadora por sumas prefijas y su slot, tomado de la lista libre como
+// lo haría maestroCrear (los TOTAL_LOTES reservan en su lugar del archivo)
+void combinarSlots(CombinacionCSV& K, Maestro& maestro) {
+    int n = (int)K.filas.size();
+    vector<int> ganadas(K.partes + 1, 0);
+    enParalelo(K.partes, [&](int p) {
+        int ini, fin;
+        rangoParte(n, K.partes, p, ini, fin);
+        for (int g = ini; g < fin; ++g) ganadas[p + 1] += K.estado[g] == LOTE_GANA;
+    });
+    for (int p = 0; p < K.partes; ++p) ganadas[p + 1] += ganadas[p];
+    K.ganadoras.resize(ganadas[K.partes]);
+    enParalelo(K.partes, [&](int p) {
+        int ini, fin;
+        rangoParte(n, K.partes, p, ini, fin);
+        int k = ganadas[p];
+        for (int g = ini; g < fin; ++g) {
+            if (K.estado[g] == LOTE_GANA) K.ganadoras[k++] = g;
+        }
+    });
+    
+    K.slot.assign(n, -1);
+    int g = 0;
+    for (int k = 0; k <= (int)K.ganadoras.size(); ++k) {
+        int hasta = k < (int)K.ganadoras.size() ? K.ganadoras[k] : n;
+        for (; g < hasta; ++g) {
+            if (K.filas[g]->tipo == CSV_TOTAL) maestroReservarCapacidad(maestro, K.filas[g]->cantidad);
+        }
+        if (k < (int)K.ganadoras.size()) K.slot[g++] = maestroReservar(maestro);
+    }
+}
+
+// Escribe las ganadoras en el maestro y las coloca en el almacén
+void combinarAplicar(CombinacionCSV& K, Almacen& A, Maestro& maestro) {
+    int ganadas = (int)K.ganadoras.size();
+    
+    // Bloques del maestro en paralelo; índice y listas por nombre en orden, aparte
+    enParalelo(K.partes + 1, [&](int p) {
+        if (p == K.partes) {
+            TablaNombres& t = maestro.nombres;
+            for (int g : K.ganadoras) {
+                int s = K.slot[g], nid = K.nid[g];
+                indiceInsertar(maestro.indice, K.filas[g]->id, s);
+                maestroAntNombre(maestro, s) = -1;
+                maestroSigNombre(maestro, s) = t.primero[nid];
+                if (t.primero[nid] != -1) maestroAntNombre(maestro, t.primero[nid]) = s;
+                t.primero[nid] = s;
+                t.cuenta[nid]++;
+            }
+            return;
+        }
+        int ini, fin;
+        rangoParte(ganadas, K.partes, p, ini, fin, MAESTRO_BLOQUE);
+        for (int k = ini; k < fin; ++k) {
+            int g = K.ganadoras[k], s = K.slot[g];
+            const FilaCSV& fila = *K.filas[g];
+            maestroId(maestro, s) = fila.id;
+            maestroCantidad(maestro, s) = fila.cantidad;
+            maestroPeso(maestro, s) = fila.peso;
+            maestroCelda(maestro, s) = fila.f * A.columnas + fila.c;
+            maestroNombreId(maestro, s) = K.nid[g];
+        }
+    });
+    
+    // Cada rango de filas coloca sus lotes; los totales (y la tabla DISPERSA), en orden
+    enParalelo(K.partes + 1, [&](int p) {
+        if (p == K.partes) {
+            for (int g : K.ganadoras) {
+                int s = K.slot[g];
+                if (A.modo == ALMACEN_DISPERSO) indiceInsertar(A.disperso, maestroCelda(maestro, s), s);
+                almacenAcumularTotales(A, maestro, s, +1);
+            }
+            return;
+        }
+        for (int g : K.filasParticion[p]) {
+            if (K.estado[g] != LOTE_GANA) continue;
+            int s = K.slot[g], idx = maestroCelda(maestro, s);
+            if (A.modo == ALMACEN_DENSO) A.celdas[almacenPosicion(A, idx)] = s;
+            almacenMarcar(A, idx, true);
+            almacenAcumularFila(A, maestro, K.filas[g]->f, s, +1);
+        }
+    });
+}
+
+// Importación paralela de un archivo mapeado en memoria
+// ALGORITMO:
+// 1. Dividir el archivo en trozos que terminan en un salto de línea
+// 2. Analizar cada trozo en su propio hilo (sin tocar estructuras compartidas)
+// 3. Reservar el maestro una sola vez para todas las filas de lote
+// 4. Combinar en paralelo con el mismo resultado que en orden de archivo (ver arriba)
+// 5. Informar errores y el almacén creado en orden de archivo
+void importarParalelo(const char* datos, size_t tam, int hilos, Almacen*& A, Maestro& maestro, ResumenImportacion& r) {
+    // Paso 1: Límites de los trozos alineados a '\n'
+    vector<const char*> cortes(1, datos);
+    for (int i = 1; i < hilos; ++i) {
+        const char* p = max(datos + tam * i / hilos, cortes.back());
+        const char* nl = (const char*)memchr(p, '\n', datos + tam - p);
+        cortes.push_back(nl ? nl + 1 : datos + tam);
+    }
+    cortes.push_back(datos + tam);
+    
+    // Paso 2: Análisis en paralelo
+    int trozos = (int)cortes.size() - 1;
+    vector<vector<FilaCSV>> resultados(trozos);
+    vector<int> lineas(trozos, 0);
+    vector<thread> trabajadores;
+    for (int t = 0; t < trozos; ++t) {
+        resultados[t].reserve((cortes[t + 1] - cortes[t]) / 32);
+        trabajadores.emplace_back(analizarTrozoCSV, cortes[t], cortes[t + 1], &resultados[t], &lineas[t]);
+    }
+    for (thread& h : trabajadores) h.join();
+    
+    // Paso 3: Filas en orden de archivo con números de línea globales; reserva única
+    // del maestro para las filas de lote
+    CombinacionCSV K;
+    K.partes = hilos;
+    vector<int> inicio(trozos + 1, 0), base(trozos + 1, 0);
+    for (int t = 0; t < trozos; ++t) {
+        inicio[t + 1] = inicio[t] + (int)resultados[t].size();
+        base[t + 1] = base[t] + lineas[t];
+    }
+    K.filas.resize(inicio[trozos]);
+    vector<int> lotes(trozos, 0);
+    enParalelo(trozos, [&](int t) {
+        for (size_t i = 0; i < resultados[t].size(); ++i) {
+            FilaCSV& fila = resultados[t][i];
+            fila.linea += base[t];
+            lotes[t] += fila.tipo == CSV_LOTE;
+            K.filas[inicio[t] + i] = &fila;
+        }
+    });
+    size_t totalLotes = 0;
+    for (int n : lotes) totalLotes += n;
+    maestroReservarCapacidad(maestro, (int)totalLotes);
+    
+    // Paso 4: El primer DIMENSIONES crea el almacén si no había; decidir, internar
+    // nombres, asignar slots y aplicar
+    int n = (int)K.filas.size();
+    int creado = -1, desde = 0;
+    if (A == nullptr) {
+        for (creado = 0; creado < n && K.filas[creado]->tipo != CSV_DIMENSIONES; ++creado) {}
+        if (creado < n) A = crearAlmacen(K.filas[creado]->f, K.filas[creado]->c);
+        desde = creado;
+    }
+    K.A = A;
+    combinarResolver(K, maestro, desde);
+    combinarNombres(K, maestro.nombres);
+    combinarSlots(K, maestro);
+    if (A) combinarAplicar(K, *A, maestro);
+    
+    // Paso 5: Mensajes en orden de archivo
+    r.importados += (int)K.ganadoras.size();
+    for (int g = 0; g < n; ++g) {
+        const FilaCSV& fila = *K.filas[g];
+        if (g == creado) {
+            cout << "Almacén recreado: " << A->filas << "x" << A->columnas << endl;
+        } else if (fila.tipo == CSV_ERROR) {
+            errorImportacion(r, fila.linea, "fila mal formada, se omite");
+        } else if (K.estado[g] == LOTE_SIN_ALMACEN) {
+            errorImportacion(r, fila.linea, "lote antes de DIMENSIONES, se omite", fila.id);
+        } else if (K.estado[g] == LOTE_DUPLICADO) {
+            errorImportacion(r, fila.linea, "ID duplicado, se omite", fila.id);
+        } else if (K.estado[g] == LOTE_PIERDE) {
+            errorImportacion(r, fila.linea, "posición inválida u ocupada", fila.id);
+        }
+    }
+}
+
+// Importa datos desde un archivo CSV al almacén
+// Las filas mal formadas, IDs duplicados y celdas inválidas u ocupadas se informan con
+// su número de línea y se omiten; al final se muestra un resumen
+// COMPLEJIDAD: O(tamaño del archivo). Archivos grandes se analizan en paralelo
+bool importarDatos(Almacen*& A, Maestro& maestro, const char* nombreArchivo) {
+    METRICA_TIEMPO(MET_IMPORTAR);
+    ifstream archivo(nombreArchivo, ios::binary | ios::ate);
+    if (!archivo.is_open()) {
+        cout << "✗ Error: No se pudo abrir el archivo " << nombreArchivo << endl;
+        return false;
+    }
+    size_t tam = (size_t)archivo.tellg();
+    archivo.seekg(0);
+    
+    cout << "Importando datos del almacén..." << endl;
+    ResumenImportacion r = {0, 0};
+    
+    int hilos = min((int)thread::hardware_concurrency(), MAX_HILOS_IMPORTACION);
+    const char* datos = nullptr;
+    if (hilos > 1 && tam >= UMBRAL_IMPORTACION_PARALELA) datos = mapearArchivo(nombreArchivo, tam);
+    
+    if (datos) {
+        importarParalelo(datos, tam, hilos, A, maestro, r);
+        liberarMapeo(datos, tam);
+    } else {
+        importarSecuencial(archivo, A, maestro, r);
+    }
+    
+    archivo.close();
+    cout << "✓ Importación completada: " << r.importados << " lotes importados. Lotes activos: " << maestro.size;
+    if (r.errores > 0) cout << " (" << r.errores << " línea(s) con errores)";
+    cout << endl;
+    return true;
+}
+
+/*======================================================================================
+SNAPSHOT BINARIO (BACKUP/RESTAURACIÓN RÁPIDOS)
+======================================================================================
+Formato versionado (orden de bytes nativo de la máquina):
+  [CabeceraSnapshot][LoteProduccion x lotes][int32 celda x lotes]
+- Los lotes se escriben como arreglo empaquetado, tal como están en memoria
+- celda[i] es la celda del lote i (f*columnas+c) o -1 si no está colocado
+- checksum = FNV-1a de 64 bits sobre todo lo que sigue a la cabecera
+La restauración mapea el archivo en memoria (mmap) y reconstruye Maestro y almacén con
+copias en bloque; el CSV (exportarDatos/importarDatos) se mantiene para intercambio.
+======================================================================================*/
+const char SNAPSHOT_MAGIA[8] = {'A', 'L', 'P', 'H', 'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const char* const ARCHIVO_BACKUP = "backup_almacen.bin";
+const char* const ARCHIVO_BACKUP_CSV = "backup_almacen.txt";  // Backups anteriores
+
+struct CabeceraSnapshot {
+    char magia[8];       // "ALPHSNAP"
+    uint32_t version;    // SNAPSHOT_VERSION
+    uint32_t tamLote;    // sizeof(LoteProduccion) al escribir
+    int32_t filas;       // Dimensiones del almacén
+    int32_t columnas;
+    int32_t lotes;       // Registros en el archivo
+    int32_t reservado;   // Alineación / uso futuro (0)
+    uint64_t checksum;   // FNV-1a 64 de los datos
+};
+
+// Hash FNV-1a de 64 bits (encadenable pasando el valor anterior en h)
+uint64_t checksumFNV(const void* datos, size_t tam, uint64_t h = 14695981039346656037ull) {
+    const unsigned char* p = (const unsigned char*)datos;
+    for (size_t i = 0; i < tam; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Guarda el estado completo (todos los lotes del maestro y sus celdas)
+// COMPLEJIDAD: O(capacidad del maestro), tres escrituras en bloque
+bool guardarSnapshot(const Almacen& A, const Maestro& maestro, const char* nombreArchivo, uint64_t* checksum = nullptr) {
+    // Paso 1: Empaquetar los lotes activos y sus celdas en arreglos contiguos
+    vector<LoteProduccion> lotes;
+    vector<int32_t> celdas;
+    lotes.reserve(maestro.size);
+    celdas.reserve(maestro.size);
+    for (int i = 0; i < maestro.cap; ++i) {
+        if (!maestroUsado(maestro, i)) continue;
+        lotes.push_back(maestroLeerLote(maestro, i));
+        celdas.push_back(maestroCelda(maestro, i));
+    }
+    
+    // Paso 2: Cabecera con checksum
+    CabeceraSnapshot cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magia, SNAPSHOT_MAGIA, sizeof(cab.magia));
+    cab.version = SNAPSHOT_VERSION;
+    cab.tamLote = sizeof(LoteProduccion);
+    cab.filas = A.filas;
+    cab.columnas = A.columnas;
+    cab.lotes = (int32_t)lotes.size();
+    cab.checksum = checksumFNV(lotes.data(), lotes.size() * sizeof(LoteProduccion));
+    cab.checksum = checksumFNV(celdas.data(), celdas.size() * sizeof(int32_t), cab.checksum);
+    if (checksum) *checksum = cab.checksum;
+    
+    // Paso 3: Escritura en bloque
+    ofstream archivo(nombreArchivo, ios::binary | ios::trunc);
+    if (!archivo.is_open()) {
+        cout << "✗ Error: No se pudo crear el archivo " << nombreArchivo << endl;
+        return false;
+    }
+    archivo.write((const char*)&cab, sizeof(cab));
+    archivo.write((const char*)lotes.data(), lotes.size() * sizeof(LoteProduccion));
+    archivo.write((const char*)celdas.data(), celdas.size() * sizeof(int32_t));
+    archivo.close();
+    if (!archivo) {
+        cout << "✗ Error: Falló la escritura de " << nombreArchivo << endl;
+        return false;
+    }
+    
+    cout << "✓ Snapshot guardado: " << lotes.size() << " lotes en " << nombreArchivo << endl;
+    return true;
+}
+
+// Restaura el estado desde un snapshot binario (A debe ser nullptr y el maestro vacío)
+// COMPLEJIDAD: O(lotes) con copias en bloque, sin parseo de texto
+bool cargarSnapshot(Almacen*& A, Maestro& maestro, const char* nombreArchivo, uint64_t* checksum = nullptr) {
+    size_t tam = 0;
+    const char* datos = mapearArchivo(nombreArchivo, tam);
+    if (!datos) {
+        cout << "✗ Error: No se pudo abrir el archivo " << nombreArchivo << endl;
+        return false;
+    }
+    
+    // Paso 1: Validar cabecera, tamaño y checksum
+    CabeceraSnapshot cab;
+    bool valido = (tam >= sizeof(cab));
+    if (valido) {
+        memcpy(&cab, datos, sizeof(cab));
+        valido = memcmp(cab.magia, SNAPSHOT_MAGIA, sizeof(cab.magia)) == 0
+              && cab.version == SNAPSHOT_VERSION
+              && cab.tamLote == sizeof(LoteProduccion)
+              && cab.filas >= 1 && cab.filas <= MAX_DIMENSION
+              && cab.columnas >= 1 && cab.columnas <= MAX_DIMENSION
+              && cab.lotes >= 0
+              && tam == sizeof(cab) + (size_t)cab.lotes * (sizeof(LoteProduccion) + sizeof(int32_t));
+    }
+    const char* lotes = datos + sizeof(cab);
+    const char* celdas = lotes + (valido ? (size_t)cab.lotes * sizeof(LoteProduccion) : 0);
+    if (valido) {
+        uint64_t h = checksumFNV(lotes, tam - sizeof(cab));
+        valido = (h == cab.checksum);
+        if (checksum) *checksum = cab.checksum;
+    }
+    if (!valido) {
+        cout << "✗ Error: Snapshot inválido o corrupto: " << nombreArchivo << endl;
+        liberarMapeo(datos, tam);
+        return false;
+    }
+    
+    // Paso 2: Copia masiva de los lotes al maestro
+    if (!maestroCargar(maestro, (const LoteProduccion*)lotes, cab.lotes)) {
+        cout << "✗ Error: El snapshot contiene IDs de lote duplicados" << endl;
+        liberarMapeo(datos, tam);
+        maestroFree(maestro);
+        maestroInit(maestro);
+        return false;
+    }
+    
+    // Paso 3: Recrear el almacén y ubicar cada lote (el lote i está en el slot i)
+    A = crearAlmacen(cab.filas, cab.columnas);
+    int N = cab.filas * cab.columnas, colocados = 0;
+    for (int i = 0; i < cab.lotes; ++i) {
+        int32_t celda;
+        memcpy(&celda, celdas + (size_t)i * sizeof(int32_t), sizeof(celda));
+        if (celda < 0 || celda >= N || almacenOcupada(*A, celda)) continue;
+        almacenPoner(*A, maestro, celda, i);
+        maestroCelda(maestro, i) = celda;
+        colocados++;
+    }
+    liberarMapeo(datos, tam);
+    
+    cout << "✓ Snapshot restaurado: almacén " << A->filas << "x" << A->columnas << ", "
+         << maestro.size << " lotes (" << colocados << " colocados)" << endl;
+    return true;
+}
+
+// Agrega a 'slots' los slots del maestro con cantidadTotal <= umbral (los libres nunca pasan)
+// ALGORITMO: Filtra la columna cantidadTotal de cada bloque con el kernel vectorial
+// (4 bytes por lote, acceso secuencial)
+// COMPLEJIDAD: O(capacidad del maestro) a velocidad de memoria
+void maestroCantidadHasta(const Maestro& maestro, int umbral, vector<int>& slots) {
+    const KernelsColumnas& kernels = kernelsColumnas();
+    int sel[MAESTRO_BLOQUE];
+    for (int b = 0; b < maestro.nBloques; ++b) {
+        int k = kernels.filtrarHasta(maestro.bloques[b]->cantidadTotal, MAESTRO_BLOQUE, umbral, sel);
+        int base = b * MAESTRO_BLOQUE;
+        for (int i = 0; i < k; ++i) slots.push_back(base + sel[i]);
+    }
+}
+
+// Función para detectar y alertar sobre stock bajo
+// ALGORITMO: Filtra la columna de cantidades del maestro (sin tocar nombres ni celdas) y
+// solo para los candidatos consulta la celda; las alertas se listan por posición.
+// COMPLEJIDAD: O(capacidad del maestro) secuencial + O(k log k) con k alertas
+void verificarStockBajo(const Almacen& A, const Maestro& maestro, int umbralMinimo = 10) {
+    cout << "\n=== VERIFICACIÓN DE STOCK BAJO ===" << endl;
+    
+    // Paso 1: Candidatos por cantidad
+    vector<int> slots;
+    maestroCantidadHasta(maestro, min(umbralMinimo, CANTIDAD_LIBRE - 1), slots);
+    
+    // Paso 2: Solo los lotes colocados en este almacén, ordenados por celda
+    vector<pair<int, int>> alertas;  // (celda, slot)
+    for (int slot : slots) {
+        int celda = maestroCelda(maestro, slot);
+        if (celda != -1 && almacenSlot(A, celda) == slot) alertas.push_back({celda, slot});
+    }
+    sort(alertas.begin(), alertas.end());
+    
+    bool hayAlertas = !alertas.empty();
+    if (hayAlertas) {
+        cout << "ALERTAS DE STOCK BAJO (≤" << umbralMinimo << " unidades):" << endl;
+    }
+    for (const pair<int, int>& a : alertas) {
+        cout << "  - Lote " << maestroId(maestro, a.second) 
+             << " (" << maestroNombre(maestro, a.second) << "): " 
+             << maestroCantidad(maestro, a.second) << " unidades restantes" << endl;
+    }
+    
+    if (!hayAlertas) {
+        cout << "✓ No hay alertas de stock bajo." << endl;
+    }
+}
+
+/*======================================================================================
+DIARIO DE OPERACIONES (WRITE-AHEAD LOG)
+======================================================================================
+Cada operación que modifica el estado se agrega al final de diario_almacen.log como un
+registro binario de tamaño fijo. Al iniciar, el sistema carga el último snapshot y
+vuelve a aplicar el diario encima, así se recupera el estado incluso tras un corte.
+Formato:
+  [CabeceraDiario][RegistroDiario x N]
+- La cabecera guarda el checksum del snapshot sobre el que se aplica el diario; si no
+  coincide con el snapshot cargado, el diario se ignora (es de otro estado base)
+- Cada registro lleva su propio checksum: un registro incompleto al final (escritura
+  cortada) detiene la reproducción sin afectar a los anteriores
+- Colocación en bloque: DIARIO_LOTES anuncia n registros DIARIO_COLOCAR; si alguno
+  falta o está dañado, la reproducción se detiene antes del bloque (todo o nada)
+- Confirmación en grupo: los registros se acumulan en memoria y se escriben con un
+  solo fsync cada 'grupo' registros (DIARIO_GRUPO en el menú) o antes de esperar una
+  nueva entrada
+- Compactación: al superar DIARIO_UMBRAL_COMPACTAR bytes se guarda un snapshot nuevo
+  y el diario se reinicia vacío
+- Las inspecciones no pasan por el diario: tienen su propia bitácora en disco
+COMPLEJIDAD: O(1) por operación registrada; O(estado) solo al compactar
+======================================================================================*/
+const char DIARIO_MAGIA[8] = {'A', 'L', 'P', 'H', 'D', 'I', 'A', 'R'};
+const uint32_t DIARIO_VERSION = 1;
+const char* const ARCHIVO_DIARIO = "diario_almacen.log";
+const int DIARIO_GRUPO = 64;                          // Registros por fsync
+const size_t DIARIO_UMBRAL_COMPACTAR = 4 << 20;      // 4 MB (~50.000 registros)
+
+// Tipos de registro
+const uint32_t DIARIO_ALMACEN = 1;       // a=filas, b=columnas (almacén nuevo, lotes sin posición)
+const uint32_t DIARIO_REDIMENSIONAR = 2; // a=filas, b=columnas
+const uint32_t DIARIO_COLOCAR = 3;       // a=id, b=fila, c=columna + datos del lote
+const uint32_t DIARIO_MOVER = 4;         // a=fila origen, b=columna origen, c=fila destino, d=columna destino
+const uint32_t DIARIO_REMOVER = 5;       // a=id
+const uint32_t DIARIO_LOTES = 6;         // a=n: siguen n DIARIO_COLOCAR que se aplican todos o ninguno
+
+struct CabeceraDiario {
+    char magia[8];         // "ALPHDIAR"
+    uint32_t version;      // DIARIO_VERSION
+    uint32_t tamRegistro;  // sizeof(RegistroDiario)
+    uint64_t base;         // Checksum del snapshot base (0 = sin snapshot)
+};
+
+struct RegistroDiario {
+    uint32_t tipo;               // DIARIO_*
+    int32_t a, b, c, d;          // Parámetros según el tipo
+    float peso;                  // DIARIO_COLOCAR
+    int32_t cantidad;            // DIARIO_COLOCAR
+    char nombre[NOMBRE_MAX];     // DIARIO_COLOCAR
+    char reservado[2];           // Relleno explícito (0)
+    uint32_t checksum;           // FNV-1a (32 bits bajos) de los campos anteriores
+};
+
+struct Diario {
+    FILE* archivo;         // Abierto en modo agregar (nullptr si no hay diario)
+    RegistroDiario* pendientes;  // Registros aún no escritos (capacidad 'grupo')
+    int nPendientes;
+    int grupo;             // Registros por fsync
+    size_t bytes;          // Tamaño del archivo incluyendo los pendientes
+    bool error;            // No se pudo escribir o (re)abrir: no se aceptan más cambios
+};
+
+void diarioInit(Diario& D, int grupo = DIARIO_GRUPO) {
+    D.archivo = nullptr;
+    D.grupo = grupo;
+    D.pendientes = new RegistroDiario[grupo];
+    D.nPendientes = 0;
+    D.bytes = 0;
+    D.error = false;
+}
+
+// Escribe los registros pendientes con una sola escritura y un solo fsync
+bool diarioSincronizar(Diario& D) {
+    if (!D.archivo || D.nPendientes == 0) return true;
+    size_t escritos = fwrite(D.pendientes, sizeof(RegistroDiario), D.nPendientes, D.archivo);
+    bool ok = sincronizarArchivo(D.archivo) && (escritos == (size_t)D.nPendientes);
+    if (!ok) {
+        cout << "✗ Error: No se pudo escribir el diario de operaciones" << endl;
+        D.error = true;
+    }
+    D.nPendientes = 0;
+    return ok;
+}
+
+void diarioCerrar(Diario& D) {
+    diarioSincronizar(D);
+    if (D.archivo) fclose(D.archivo);
+    D.archivo = nullptr;
+}
+
+void diarioFree(Diario& D) {
+    diarioCerrar(D);
+    delete[] D.pendientes;
+    D.pendientes = nullptr;
+}
+
+uint32_t checksumRegistro(const RegistroDiario& r) {
+    return (uint32_t)checksumFNV(&r, offsetof(RegistroDiario, checksum));
+}
+
+// Agrega una operación al diario (se confirma en disco en grupo)
+// Si se indica un slot del maestro, el registro lleva también los datos de ese lote
+// COMPLEJIDAD: O(1); un fsync cada D.grupo registros
+void diarioAnotar(Diario& D, uint32_t tipo, int a = 0, int b = 0, int c = 0, int d = 0,
+                  const Maestro* maestro = nullptr, int slot = -1) {
+    if (!D.archivo) return;
+    RegistroDiario& r = D.pendientes[D.nPendientes];
+    memset(&r, 0, sizeof(r));
+    r.tipo = tipo;
+    r.a = a; r.b = b; r.c = c; r.d = d;
+    if (maestro) {
+        r.peso = maestroPeso(*maestro, slot);
+        r.cantidad = maestroCantidad(*maestro, slot);
+        memcpy(r.nombre, maestroNombre(*maestro, slot), NOMBRE_MAX);
+    }
+    r.checksum = checksumRegistro(r);
+    D.bytes += sizeof(RegistroDiario);
+    if (++D.nPendientes == D.grupo) diarioSincronizar(D);
+}
+
+// Anota una colocación en bloque (colocarLotes): DIARIO_LOTES y un DIARIO_COLOCAR por lote
+void diarioAnotarLotes(Diario& D, const Almacen& A, const Maestro& maestro, const LoteProduccion* lotes,
+                       const int* celdas, int n) {
+    diarioAnotar(D, DIARIO_LOTES, n);
+    for (int i = 0; i < n; ++i) {
+        diarioAnotar(D, DIARIO_COLOCAR, lotes[i].idLote, celdas[i] / A.columnas, celdas[i] % A.columnas, 0,
+                     &maestro, maestroBuscarID(maestro, lotes[i].idLote));
+    }
+}
+
+// Crea un diario vacío sobre el snapshot indicado (vía archivo temporal + rename)
+bool diarioReiniciar(Diario& D, uint64_t base) {
+    diarioCerrar(D);
+    D.nPendientes = 0;
+    string temporal = string(ARCHIVO_DIARIO) + ".tmp";
+    FILE* archivo = fopen(temporal.c_str(), "wb");
+    if (!archivo) {
+        cout << "✗ Error: No se pudo crear el diario " << ARCHIVO_DIARIO << endl;
+        D.error = true;
+        return false;
+    }
+    CabeceraDiario cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magia, DIARIO_MAGIA, sizeof(cab.magia));
+    cab.version = DIARIO_VERSION;
+    cab.tamRegistro = sizeof(RegistroDiario);
+    cab.base = base;
+    bool ok = fwrite(&cab, sizeof(cab), 1, archivo) == 1;
+    ok = sincronizarArchivo(archivo) && ok;
+    fclose(archivo);
+    if (ok && rename(temporal.c_str(), ARCHIVO_DIARIO) == 0 && sincronizarDirectorio(ARCHIVO_DIARIO)) {
+        D.archivo = fopen(ARCHIVO_DIARIO, "ab");
+    }
+    if (!D.archivo) {
+        cout << "✗ Error: No se pudo crear el diario " << ARCHIVO_DIARIO << endl;
+        D.error = true;
+        return false;
+    }
+    D.bytes = sizeof(cab);
+    D.error = false;
+    return true;
+}
+
+// Aplica un registro del diario al estado (misma lógica que el menú, sin mensajes)
+// RETORNA: true si la operación se pudo aplicar
+bool aplicarRegistro(const RegistroDiario& r, Almacen*& A, Maestro& maestro) {
+    switch (r.tipo) {
+        case DIARIO_ALMACEN:
+            if (r.a < 1 || r.a > MAX_DIMENSION || r.b < 1 || r.b > MAX_DIMENSION) return false;
+            if (A) {
+                liberarAlmacen(A);
+                maestroDesubicar(maestro);
+            }
+            A = crearAlmacen(r.a, r.b);
+            return true;
+        case DIARIO_REDIMENSIONAR: {
+            if (!A || r.a < 1 || r.a > MAX_DIMENSION || r.b < 1 || r.b > MAX_DIMENSION) return false;
+            vector<int> fuera;
+            redimensionarAlmacen(A, maestro, r.a, r.b, fuera);
+            return true;
+        }
+        case DIARIO_COLOCAR: {
+            if (!A) return false;
+            char nombre[NOMBRE_MAX];
+            memcpy(nombre, r.nombre, NOMBRE_MAX);
+            nombre[NOMBRE_MAX - 1] = '\0';
+            // Un lote que quedó sin posición se vuelve a colocar (PLACE f c id)
+            int existente = maestroBuscarID(maestro, r.a);
+            if (existente != -1) return ubicarLote(*A, maestro, r.a, r.b, r.c) != -1;
+            int slot = maestroCrear(maestro, r.a, nombre, r.peso, r.cantidad);
+            if (slot == -1) return false;
+            if (colocar(*A, maestro, r.b, r.c, slot)) return true;
+            maestroEliminar(maestro, r.a);
+            return false;
+        }
+        case DIARIO_MOVER:
+            return A && moverLote(*A, maestro, r.a, r.b, r.c, r.d);
+        case DIARIO_REMOVER:
+            return A && removerLote(*A, maestro, r.a);
+        case DIARIO_LOTES:
+            return true;  // Solo marca el inicio; reproducirDiario comprueba que esté completo
+        default:
+            return false;
+    }
+}
+
+// Reproduce el diario sobre el estado cargado desde el snapshot con checksum base
+// RETORNA: registros aplicados, o -1 si el diario no existe o no corresponde a la base
+// 'completo' indica si el archivo terminó sin registros cortados o corruptos
+int reproducirDiario(Almacen*& A, Maestro& maestro, uint64_t base, bool& completo) {
+    completo = true;
+    size_t tam = 0;
+    const char* datos = mapearArchivo(ARCHIVO_DIARIO, tam);
+    if (!datos) return -1;
+    
+    // Paso 1: Validar la cabecera y el snapshot base
+    CabeceraDiario cab;
+    bool valido = (tam >= sizeof(cab));
+    if (valido) {
+        memcpy(&cab, datos, sizeof(cab));
+        valido = memcmp(cab.magia, DIARIO_MAGIA, sizeof(cab.magia)) == 0
+              && cab.version == DIARIO_VERSION
+              && cab.tamRegistro == sizeof(RegistroDiario);
+    }
+    if (!valido || cab.base != base) {
+        if (!valido) cout << "✗ Diario inválido, se ignora: " << ARCHIVO_DIARIO << endl;
+        else cout << "✗ El diario no corresponde al snapshot actual, se ignora" << endl;
+        liberarMapeo(datos, tam);
+        return -1;
+    }
+    
+    // Paso 2: Aplicar los registros válidos en orden (se detiene en el primero dañado)
+    // Una colocación en bloque se aplica solo si están todos sus registros
+    int aplicados = 0;
+    size_t n = (tam - sizeof(cab)) / sizeof(RegistroDiario);
+    completo = (sizeof(cab) + n * sizeof(RegistroDiario) == tam);
+    RegistroDiario r, s;
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(&r, datos + sizeof(cab) + i * sizeof(RegistroDiario), sizeof(r));
+        bool registroValido = (r.checksum == checksumRegistro(r));
+        if (registroValido && r.tipo == DIARIO_LOTES) {
+            size_t fin = i + 1 + (size_t)max(r.a, 0);
+            registroValido = (fin <= n);
+            for (size_t j = i + 1; registroValido && j < fin; ++j) {
+                memcpy(&s, datos + sizeof(cab) + j * sizeof(RegistroDiario), sizeof(s));
+                registroValido = (s.checksum == checksumRegistro(s));
+            }
+        }
+        if (!registroValido) {
+            completo = false;
+            break;
+        }
+        aplicarRegistro(r, A, maestro);
+        aplicados++;
+    }
+    liberarMapeo(datos, tam);
+    return aplicados;
+}
+
+// Guarda un snapshot nuevo y reinicia el diario sobre él
+// Orden seguro ante cortes: snapshot temporal -> fsync -> rename -> fsync del directorio
+// -> diario nuevo (igual: temporal -> fsync -> rename -> fsync del directorio).
+// Si se corta entre ambos pasos, el diario viejo ya no coincide con la base y se ignora;
+// el fsync del directorio impide que sobreviva el diario nuevo sin el snapshot nuevo
+// COMPLEJIDAD: O(estado)
+bool compactarDiario(const Almacen* A, const Maestro& maestro, Diario& D) {
+    if (!A) {
+        cout << "✗ Error: No hay almacén para respaldar." << endl;
+        return false;
+    }
+    diarioSincronizar(D);
+    
+    // Paso 1: Snapshot a un archivo temporal confirmado en disco
+    string temporal = string(ARCHIVO_BACKUP) + ".tmp";
+    uint64_t base = 0;
+    if (!guardarSnapshot(*A, maestro, temporal.c_str(), &base)) return false;
+    FILE* archivo = fopen(temporal.c_str(), "rb+");
+    bool ok = (archivo != nullptr) && sincronizarArchivo(archivo);
+    if (archivo) fclose(archivo);
+    if (!ok) {
+        cout << "✗ Error: No se pudo confirmar en disco " << temporal << endl;
+        remove(temporal.c_str());
+        return false;
+    }
+    if (rename(temporal.c_str(), ARCHIVO_BACKUP) != 0) {
+        cout << "✗ Error: No se pudo reemplazar " << ARCHIVO_BACKUP << endl;
+        return false;
+    }
+    if (!sincronizarDirectorio(ARCHIVO_BACKUP)) {
+        // El snapshot nuevo puede no sobrevivir a un corte: no se reinicia el diario
+        // ni se aceptan más cambios
+        cout << "✗ Error: No se pudo confirmar en disco " << ARCHIVO_BACKUP << endl;
+        D.error = true;
+        return false;
+    }
+    
+    // Paso 2: Diario nuevo y vacío sobre el snapshot
+    return diarioReiniciar(D, base);
+}
+
+// Compacta el diario si superó el umbral de tamaño
+void diarioMantenimiento(const Almacen* A, const Maestro& maestro, Diario& D) {
+    diarioSincronizar(D);
+    if (D.archivo && A && D.bytes >= DIARIO_UMBRAL_COMPACTAR) {
+        if (compactarDiario(A, maestro, D)) cout << "✓ Diario de operaciones compactado" << endl;
+    }
+}
+
+// Crea un backup del estado completo: snapshot binario + diario reiniciado
+bool crearBackup(const Almacen* A, const Maestro& maestro, Diario& D) {
+    return compactarDiario(A, maestro, D);
+}
+
+// Restaura el último estado confirmado: snapshot + reproducción del diario
+// Sin snapshot binario se usa el CSV de versiones anteriores (sin diario)
+// Deja el diario abierto para seguir registrando operaciones
+// RETORNA: false si el snapshot está dañado (el estado actual y su diario no se tocan)
+//          o si no quedó un diario abierto (D.error: no se deben aceptar cambios)
+bool restaurarBackup(Almacen*& A, Maestro& maestro, Diario& D) {
+    // Paso 1: Estado base en estructuras nuevas; nada se desmonta hasta validarlo
+    Almacen* nuevo = nullptr;
+    Maestro nuevoMaestro;
+    maestroInit(nuevoMaestro);
+    uint64_t base = 0;
+    bool hayBase = false;
+    if (ifstream(ARCHIVO_BACKUP).good()) {
+        hayBase = cargarSnapshot(nuevo, nuevoMaestro, ARCHIVO_BACKUP, &base);
+        if (!hayBase) {  // No reescribir nada sobre un snapshot dañado
+            maestroFree(nuevoMaestro);
+            return false;
+        }
+    } else if (ifstream(ARCHIVO_BACKUP_CSV).good()) {
+        hayBase = importarDatos(nuevo, nuevoMaestro, ARCHIVO_BACKUP_CSV);
+    }
+    
+    // Paso 2: Reemplazar el estado actual
+    diarioCerrar(D);
+    if (A) liberarAlmacen(A);
+    maestroFree(maestro);
+    A = nuevo;
+    maestro = nuevoMaestro;
+    
+    // Paso 3: Reproducir el diario y seguir agregando al mismo archivo
+    bool completo;
+    int aplicados = reproducirDiario(A, maestro, base, completo);
+    if (aplicados > 0) cout << "✓ Diario reproducido: " << aplicados << " operaciones recuperadas" << endl;
+    if (aplicados >= 0 && completo) {
+        D.archivo = fopen(ARCHIVO_DIARIO, "ab");
+        if (D.archivo) {
+            fseek(D.archivo, 0, SEEK_END);
+            D.bytes = (size_t)ftell(D.archivo);
+        }
+    } else if (A && (aplicados > 0 || !completo || hayBase)) {
+        // Paso 4: Sin diario utilizable (o con la cola dañada): empezar uno nuevo.
+        // Si ya hay estado recuperado se compacta primero para no perderlo
+        compactarDiario(A, maestro, D);
+    } else {
+        diarioReiniciar(D, base);
+    }
+    D.error = (D.archivo == nullptr);
+    return !D.error;
+}
+
+/*======================================================================================
+ACCESO CONCURRENTE AL ALMACÉN
+======================================================================================
+Varias estaciones de inspección y terminales de montacargas pueden operar a la vez con
+las funciones conc* sobre un AlmacenConcurrente. El resto del programa (menú, modo por
+lotes, redimensionar, importar, restaurar, reportes completos) sigue siendo de un solo
+hilo y se usa con las terminales detenidas.
+CANDADOS, siempre tomados en este orden (así ningún par de hilos puede interbloquearse):
+1. Maestro (lector/escritor): crear o eliminar lotes cambia el índice hash, el slab y
+   los nombres y toma el modo exclusivo; todo lo demás toma el compartido, así las
+   búsquedas por ID y las operaciones sobre filas distintas corren en paralelo.
+2. Franjas de filas: FRANJAS_ALMACEN mutex; la fila f usa la franja f % FRANJAS_ALMACEN.
+   Cada franja protege las celdas, el mapa de ocupación y los subtotales de sus filas.
+   Un movimiento entre filas toma sus dos franjas en orden creciente (una sola si
+   coinciden).
+3. Dentro de las franjas: la tabla celda -> slot del modo DISPERSO (única para todo el
+   almacén) y el diario. La operación se anota antes de soltar las franjas, así el
+   orden del diario coincide con el orden en que se aplicó sobre cada celda.
+Los totales (almacén y por componente) y las inspecciones (pila + bitácora) tienen su
+propio mutex y se toman sin franjas. Un movimiento no cambia los totales y no lo toma.
+LECTORES SIN BLOQUEO: los totales se publican con un seqlock en campos atómicos (mismo
+esquema que la pila), así concEstadisticas nunca espera a los escritores; la pila sigue
+con un solo escritor (el mutex de inspecciones) y lectores libres. La celda de cada lote
+se lee y escribe con acceso atómico relajado (maestroCeldaLeer/Escribir): una búsqueda
+por ID solo toma el maestro compartido.
+Las filas (concFila, reportes) se leen sin tomar ningún candado:
+- Cada franja tiene un contador de versión que el escritor pone impar al tomarla y par
+  al soltarla. El lector lee la versión, la fila y otra vez la versión, y reintenta si
+  cambió (seqlock).
+- Todo lo que lee se escribe con publicar y se lee con leerPublicado: celdas, palabras
+  de ocupación, subtotales de la fila, la tabla dispersa y el idLote de cada slot.
+- La tabla celda -> slot del modo DISPERSO es de todo el almacén: tiene su propia
+  versión (bajo candadoDisperso) y cada búsqueda se valida con ella.
+- Ningún escritor libera memoria que un lector pueda estar recorriendo. La tabla
+  dispersa y las palabras de las filas dispersas que se reemplazan al crecer quedan
+  retiradas hasta concFree; las tablas de bloques del maestro, hasta maestroFree.
+======================================================================================*/
+const int FRANJAS_ALMACEN = 64;  // Mutex de filas (potencia de 2)
+
+// Una franja por línea de caché, para que dos franjas vecinas no compitan por la misma
+struct alignas(64) FranjaFilas {
+    mutex m;
+    atomic<unsigned> version;  // Impar mientras un escritor tiene la franja (seqlock)
+};
+
+// Copia de los totales para lectores sin bloqueo (seqlock: versión impar = en curso)
+struct TotalesPublicados {
+    atomic<unsigned> version;
+    atomic<int> ocupadas;
+    atomic<long long> unidades;
+    atomic<double> peso;
+};
+
+struct AlmacenConcurrente {
+    Almacen* A;                       // Dimensiones fijas mientras haya terminales activas
+    Maestro* maestro;
+    Pila* pila;
+    BitacoraInspecciones* bitacora;   // nullptr = solo la pila
+    Diario* diario;                   // nullptr = sin diario
+    shared_mutex candadoMaestro;
+    FranjaFilas* franjas;
+    mutex candadoDisperso;
+    mutex candadoDiario;
+    mutex candadoTotales;
+    mutex candadoInspecciones;
+    TotalesPublicados totales;
+    atomic<unsigned> versionDisperso;   // Seqlock de la tabla dispersa (bajo candadoDisperso)
+    vector<IndiceID> tablasRetiradas;   // Memoria reemplazada que un lector puede estar
+    vector<FilaDispersa> filasRetiradas;  // leyendo: se libera en concFree
+};
+
+// Franjas de una operación sobre una o dos filas
+struct FranjasTomadas {
+    FranjaFilas* primera;
+    FranjaFilas* segunda;   // nullptr si las dos filas comparten franja
+};
+
+// Publica los totales actuales para los lectores (con candadoTotales tomado)
+void concPublicarTotales(AlmacenConcurrente& C) {
+    TotalesPublicados& t = C.totales;
+    t.version.store(t.version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    t.ocupadas.store(C.A->ocupadas, memory_order_release);  // Mismo esquema que la pila
+    t.unidades.store(C.A->unidades, memory_order_release);
+    t.peso.store(C.A->peso, memory_order_release);
+    t.version.store(t.version.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+// Prepara el acceso concurrente sobre un sistema ya creado
+void concInit(AlmacenConcurrente& C, Almacen* A, Maestro& maestro, Pila& pila,
+              BitacoraInspecciones* bitacora = nullptr, Diario* diario = nullptr) {
+    C.A = A;
+    C.maestro = &maestro;
+    C.pila = &pila;
+    C.bitacora = bitacora;
+    C.diario = diario;
+    C.franjas = new FranjaFilas[FRANJAS_ALMACEN];
+    for (int i = 0; i < FRANJAS_ALMACEN; ++i) C.franjas[i].version.store(0, memory_order_relaxed);
+    C.versionDisperso.store(0, memory_order_relaxed);
+    C.totales.version.store(0, memory_order_relaxed);
+    concPublicarTotales(C);
+}
+
+void concFree(AlmacenConcurrente& C) {
+    delete[] C.franjas;
+    C.franjas = nullptr;
+    for (IndiceID& t : C.tablasRetiradas) indiceFree(t);
+    for (FilaDispersa& fd : C.filasRetiradas) {
+        delete[] fd.palabra;
+        delete[] fd.bits;
+    }
+    C.tablasRetiradas.clear();
+    C.filasRetiradas.clear();
+}
+
+// Versión de un seqlock: impar mientras dura la escritura (con su candado tomado). Las
+// escrituras protegidas se publican con release, así ninguna se adelanta a la versión impar
+inline void concAbrirVersion(atomic<unsigned>& version) {
+    version.store(version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+inline void concCerrarVersion(atomic<unsigned>& version) {
+    version.store(version.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+// Toma las franjas de las filas f1 y f2 en orden creciente
+void concTomarFilas(AlmacenConcurrente& C, int f1, int f2, FranjasTomadas& t) {
+    int a = f1 & (FRANJAS_ALMACEN - 1), b = f2 & (FRANJAS_ALMACEN - 1);
+    if (a > b) swap(a, b);
+    t.primera = &C.franjas[a];
+    t.segunda = (a == b) ? nullptr : &C.franjas[b];
+    t.primera->m.lock();
+    if (t.segunda) t.segunda->m.lock();
+    concAbrirVersion(t.primera->version);
+    if (t.segunda) concAbrirVersion(t.segunda->version);
+}
+
+void concSoltarFilas(FranjasTomadas& t) {
+    if (t.segunda) concCerrarVersion(t.segunda->version);
+    concCerrarVersion(t.primera->version);
+    if (t.segunda) t.segunda->m.unlock();
+    t.primera->m.unlock();
+}
+
+// Celda -> slot y escritura de celdas (con la franja de la fila tomada); en modo DISPERSO
+// la tabla es compartida por todas las filas y pasa además por su propio candado
+int concSlot(AlmacenConcurrente& C, int idx) {
+    if (C.A->modo == ALMACEN_DENSO) return almacenSlot(*C.A, idx);
+    lock_guard<mutex> g(C.candadoDisperso);
+    return almacenSlot(*C.A, idx);
+}
+
+void concAsignar(AlmacenConcurrente& C, int idx, int slot) {
+    Almacen& A = *C.A;
+    if (A.modo == ALMACEN_DENSO) {
+        almacenCeldaAsignar(A, idx, slot);
+        return;
+    }
+    lock_guard<mutex> g(C.candadoDisperso);
+    concAbrirVersion(C.versionDisperso);
+    // La tabla y las palabras de la fila crecen aquí, retirando lo viejo (un lector sin
+    // candado puede estar leyéndolo); así almacenCeldaAsignar ya no libera nada
+    if ((A.disperso.size + 1) * 2 > A.disperso.cap) {
+        C.tablasRetiradas.emplace_back();
+        indiceGrow(A.disperso, &C.tablasRetiradas.back());
+    }
+    FilaDispersa& fd = A.ocupacionDispersa[idx / A.columnas];
+    int w = (idx % A.columnas) >> 6;
+    int i = filaDispersaBuscar(fd, w);
+    if (!(i < fd.n && fd.palabra[i] == w) && fd.n == fd.cap) {
+        C.filasRetiradas.emplace_back();
+        filaDispersaCrecer(fd, &C.filasRetiradas.back());
+    }
+    almacenCeldaAsignar(A, idx, slot);
+    concCerrarVersion(C.versionDisperso);
+}
+
+void concVaciar(AlmacenConcurrente& C, int idx) {
+    if (C.A->modo == ALMACEN_DENSO) {
+        almacenCeldaVaciar(*C.A, idx);
+        return;
+    }
+    lock_guard<mutex> g(C.candadoDisperso);
+    concAbrirVersion(C.versionDisperso);
+    almacenCeldaVaciar(*C.A, idx);
+    concCerrarVersion(C.versionDisperso);
+}
+
+// Anota una operación en el diario (con las franjas tomadas)
+void concAnotar(AlmacenConcurrente& C, uint32_t tipo, int a = 0, int b = 0, int c = 0, int d = 0, int slot = -1) {
+    if (!C.diario) return;
+    lock_guard<mutex> g(C.candadoDiario);
+    diarioAnotar(*C.diario, tipo, a, b, c, d, slot == -1 ? nullptr : C.maestro, slot);
+}
+
+// Suma o resta el lote a los totales y los publica (con el maestro compartido tomado)
+void concAcumularTotales(AlmacenConcurrente& C, int slot, int signo) {
+    lock_guard<mutex> g(C.candadoTotales);
+    almacenAcumularTotales(*C.A, *C.maestro, slot, signo);
+    concPublicarTotales(C);
+}
+
+// Crea un lote y lo coloca en (f,c)
+// RETORNA: false si el ID ya existe o la posición es inválida u ocupada (sin dejar huérfanos)
+bool concColocar(AlmacenConcurrente& C, int f, int c, int id, const char* nombre, float peso, int cant) {
+    Almacen& A = *C.A;
+    Maestro& maestro = *C.maestro;
+    if (!almacenDentro(A, f, c)) return false;
+    
+    // Paso 1: Alta en el maestro (exclusivo: índice, slab y nombres)
+    int slot;
+    {
+        unique_lock<shared_mutex> g(C.candadoMaestro);
+        slot = maestroCrear(maestro, id, nombre, peso, cant);
+    }
+    if (slot == -1) return false;
+    
+    // Paso 2: Ocupar la celda bajo la franja de su fila
+    bool colocado = false;
+    {
+        shared_lock<shared_mutex> g(C.candadoMaestro);
+        int idx = f * A.columnas + c;
+        FranjasTomadas t;
+        concTomarFilas(C, f, f, t);
+        if (!almacenOcupada(A, idx)) {
+            concAsignar(C, idx, slot);
+            almacenAcumularFila(A, maestro, f, slot, +1);
+            maestroCeldaEscribir(maestro, slot, idx);
+            concAnotar(C, DIARIO_COLOCAR, id, f, c, 0, slot);
+            colocado = true;
+        }
+        concSoltarFilas(t);
+        if (colocado) concAcumularTotales(C, slot, +1);
+    }
+    
+    // Paso 3: Si la celda estaba ocupada, deshacer el alta
+    if (!colocado) {
+        unique_lock<shared_mutex> g(C.candadoMaestro);
+        maestroEliminar(maestro, id);
+    }
+    return colocado;
+}
+
+// Mueve el lote de (fo,co) a (fd,cd); solo toma las franjas de las dos filas
+bool concMover(AlmacenConcurrente& C, int fo, int co, int fd, int cd) {
+    Almacen& A = *C.A;
+    Maestro& maestro = *C.maestro;
+    if (!almacenDentro(A, fo, co) || !almacenDentro(A, fd, cd)) return false;
+    int idxOrigen = fo * A.columnas + co;
+    int idxDestino = fd * A.columnas + cd;
+    
+    shared_lock<shared_mutex> g(C.candadoMaestro);
+    FranjasTomadas t;
+    concTomarFilas(C, fo, fd, t);
+    int slot = concSlot(C, idxOrigen);
+    bool movido = (slot != -1 && !almacenOcupada(A, idxDestino));
+    if (movido) {
+        concVaciar(C, idxOrigen);
+        concAsignar(C, idxDestino, slot);
+        almacenAcumularFila(A, maestro, fo, slot, -1);
+        almacenAcumularFila(A, maestro, fd, slot, +1);
+        maestroCeldaEscribir(maestro, slot, idxDestino);
+        concAnotar(C, DIARIO_MOVER, fo, co, fd, cd);
+    }
+    concSoltarFilas(t);
+    return movido;
+}
+
+// Remueve un lote colocado (libera la celda y lo elimina del maestro)
+// ALGORITMO: La celda se lee sin candado; tras tomar su franja se confirma que el lote
+// sigue ahí (otro hilo pudo moverlo mientras se esperaba) y si no, se reintenta.
+bool concRemover(AlmacenConcurrente& C, int id) {
+    Almacen& A = *C.A;
+    Maestro& maestro = *C.maestro;
+    bool quitado = false;
+    {
+        shared_lock<shared_mutex> g(C.candadoMaestro);
+        int slot = maestroBuscarID(maestro, id);
+        if (slot == -1) return false;
+        for (;;) {
+            int idx = maestroCeldaLeer(maestro, slot);
+            if (idx == -1) break;  // Sin colocar (u otro hilo ya lo está removiendo)
+            int f = idx / A.columnas;
+            FranjasTomadas t;
+            concTomarFilas(C, f, f, t);
+            if (maestroCeldaLeer(maestro, slot) != idx) {
+                concSoltarFilas(t);
+                continue;
+            }
+            concVaciar(C, idx);
+            almacenAcumularFila(A, maestro, f, slot, -1);
+            maestroCeldaEscribir(maestro, slot, -1);
+            concAnotar(C, DIARIO_REMOVER, id);
+            concSoltarFilas(t);
+            quitado = true;
+            break;
+        }
+        if (quitado) concAcumularTotales(C, slot, -1);
+    }
+    if (!quitado) return false;
+    
+    // Sin celda, ningún otro hilo puede volver a tocar el lote: baja del maestro
+    unique_lock<shared_mutex> g(C.candadoMaestro);
+    maestroEliminar(maestro, id);
+    return true;
+}
+
+// Posición de un lote por ID (solo el maestro compartido)
+bool concBuscarID(AlmacenConcurrente& C, int id, int& fila, int& columna) {
+    shared_lock<shared_mutex> g(C.candadoMaestro);
+    int slot = maestroBuscarID(*C.maestro, id);
+    if (slot == -1) return false;
+    int idx = maestroCeldaLeer(*C.maestro, slot);
+    if (idx == -1) return false;
+    fila = idx / C.A->columnas;
+    columna = idx % C.A->columnas;
+    return true;
+}
+
+// Registra una inspección (bitácora + pila) de un lote existente
+// La pila solo recibe lo que quedó en la bitácora, así deshacer retira el mismo registro
+// RETORNA: false si el lote no existe o no se pudo escribir la bitácora
+bool concInspeccionar(AlmacenConcurrente& C, int id, int resultado) {
+    shared_lock<shared_mutex> g(C.candadoMaestro);
+    int slot = maestroBuscarID(*C.maestro, id);
+    if (slot == -1) return false;
+    lock_guard<mutex> inspecciones(C.candadoInspecciones);
+    if (C.bitacora && !bitacoraRegistrar(*C.bitacora, id, resultado, maestroNombre(*C.maestro, slot))) {
+        return false;
+    }
+    pilaPush(*C.pila, id, resultado);
+    return true;
+}
+
+// Totales del almacén sin bloqueo (reintenta si un escritor publicó mientras se leía)
+void concEstadisticas(const AlmacenConcurrente& C, int& ocupadas, long long& unidades, double& peso) {
+    const TotalesPublicados& t = C.totales;
+    unsigned v1, v2;
+    do {
+        v1 = t.version.load(memory_order_acquire);
+        if (v1 & 1) {
+            this_thread::yield();  // Publicación en curso
+            continue;
+        }
+        ocupadas = t.ocupadas.load(memory_order_acquire);
+        unidades = t.unidades.load(memory_order_acquire);
+        peso = t.peso.load(memory_order_acquire);
+        v2 = t.version.load(memory_order_relaxed);
+    } while ((v1 & 1) || v1 != v2);
+}
+
+// Slot de la celda idx en la tabla dispersa, sin candado (-1 si está vacía)
+// La tabla es de todas las filas: cada búsqueda se valida con la versión de la tabla
+// (un escritor de otra fila puede estar moviendo entradas del mismo grupo de sondeo)
+int concDispersoLeer(const AlmacenConcurrente& C, int idx) {
+    const IndiceID& ix = C.A->disperso;
+    for (;;) {
+        unsigned v1 = C.versionDisperso.load(memory_order_acquire);
+        if (v1 & 1) {
+            this_thread::yield();  // Escritura en curso
+            continue;
+        }
+        // La capacidad primero: con ella nueva, los arreglos también lo son
+        int cap = leerPublicado(ix.cap);
+        const int* claves = leerPublicado(ix.claves);
+        const int* slots = leerPublicado(ix.slots);
+        int slot = -1;
+        int i = indiceHash(cap, idx);
+        for (int k = 0; k < cap; ++k, i = (i + 1) & (cap - 1)) {
+            int clave = leerPublicado(claves[i]);
+            if (clave == ID_VACIO) break;
+            if (clave == idx) {
+                slot = leerPublicado(slots[i]);
+                break;
+            }
+        }
+        if (C.versionDisperso.load(memory_order_relaxed) == v1) return slot;
+    }
+}
+
+// Agrega las columnas e IDs de la fila f leyendo sin candado (un intento del seqlock)
+// RETORNA: false si se vio un estado a medio escribir (hay que reintentar)
+bool concLeerFila(const AlmacenConcurrente& C, int f, vector<int>& columnas, vector<int>& ids) {
+    const Almacen& A = *C.A;
+    int n;
+    const uint16_t* palabra = nullptr;
+    const uint64_t* bits;
+    if (A.modo == ALMACEN_DENSO) {
+        bits = leerPublicado(A.ocupacion[f]);
+        n = bits ? A.palabrasFila : 0;
+    } else {
+        const FilaDispersa& fd = A.ocupacionDispersa[f];
+        n = leerPublicado(fd.n);  // Antes que los arreglos: nunca más que su capacidad
+        palabra = leerPublicado(fd.palabra);
+        bits = leerPublicado(fd.bits);
+        if (n > A.palabrasFila) return false;
+    }
+    for (int i = 0; i < n; ++i) {
+        int w = palabra ? leerPublicado(palabra[i]) : i;
+        if (w >= A.palabrasFila) return false;
+        for (uint64_t b = leerPublicado(bits[i]); b; b &= b - 1) {
+            int c = w * 64 + bitMasBajo(b);
+            if (c >= A.columnas || (!columnas.empty() && c <= columnas.back())) return false;
+            int idx = f * A.columnas + c;
+            int slot = (A.modo == ALMACEN_DENSO) ? leerPublicado(A.celdas[almacenPosicion(A, idx)])
+                                                 : concDispersoLeer(C, idx);
+            if (slot < 0) return false;
+            columnas.push_back(c);
+            ids.push_back(maestroIdPublicado(*C.maestro, slot));
+        }
+    }
+    return true;
+}
+
+// Contenido de una fila (columnas e IDs, en orden) y sus subtotales, SIN BLOQUEO
+// ALGORITMO: seqlock de la franja de la fila. Se lee la versión (par = sin escritor),
+// la fila y sus subtotales, y otra vez la versión; si cambió, o se vio un estado a medio
+// escribir, se descarta lo leído y se reintenta. Un slot leído de una celda es válido
+// mientras la versión no cambie: para liberarlo hay que vaciar antes su celda
+// COMPLEJIDAD: O(palabras con lotes de la fila + k) por intento
+bool concFila(const AlmacenConcurrente& C, int f, vector<int>& columnas, vector<int>& ids,
+              int& ocupadas, long long& unidades, double& peso) {
+    const Almacen& A = *C.A;
+    if (f < 0 || f >= A.filas) return false;
+    const FranjaFilas& franja = C.franjas[f & (FRANJAS_ALMACEN - 1)];
+    for (;;) {
+        unsigned v1 = franja.version.load(memory_order_acquire);
+        if (v1 & 1) {
+            this_thread::yield();  // Escritura en curso
+            continue;
+        }
+        columnas.clear();
+        ids.clear();
+        bool completa = concLeerFila(C, f, columnas, ids);
+        ocupadas = leerPublicado(A.ocupadasFila[f]);
+        unidades = leerPublicado(A.unidadesFila[f]);
+        peso = leerPublicado(A.pesoFila[f]);
+        if (completa && franja.version.load(memory_order_relaxed) == v1) return true;
+    }
+}
+
+/*======================================================================================
+REPORTE DE MÉTRICAS
+======================================================================================*/
+#ifdef ALPHATECH_METRICAS
+// Percentil (0-100) de un histograma: límite inferior de la cubeta que lo contiene
+uint64_t percentilLatencia(const HistogramaLatencia& h, double p) {
+    unsigned long long objetivo = (unsigned long long)(h.muestras * p / 100.0);
+    unsigned long long acumulado = 0;
+    for (int b = 0; b < CUBETAS_METRICAS; ++b) {
+        acumulado += h.cubetas[b];
+        if (acumulado > objetivo) return inicioCubeta(b);
+    }
+    return h.maxNs;
+}
+#endif
+
+const char* const ARCHIVO_METRICAS = "metricas_almacen.txt";
+
+// Escribe el total de todos los hilos (llamadas, latencias en ns y contadores)
+void volcarMetricas(ostream& out) {
+#ifdef ALPHATECH_METRICAS
+    // Paso 1: Sumar las métricas de todos los hilos
+    MetricasHilo total;
+    memset(&total, 0, sizeof(total));
+    {
+        lock_guard<mutex> guarda(metricasMutex);
+        for (const MetricasHilo* m : metricasHilos) {
+            for (int op = 0; op < MET_TOTAL_OPERACIONES; ++op) {
+                HistogramaLatencia& t = total.ops[op];
+                const HistogramaLatencia& h = m->ops[op];
+                t.llamadas += h.llamadas;
+                t.muestras += h.muestras;
+                t.sumaNs += h.sumaNs;
+                t.maxNs = max(t.maxNs, h.maxNs);
+                for (int b = 0; b < CUBETAS_METRICAS; ++b) t.cubetas[b] += h.cubetas[b];
+            }
+            for (int c = 0; c < CNT_TOTAL_CONTADORES; ++c) total.contadores[c] += m->contadores[c];
+        }
+    }
+    
+    // Paso 2: Tabla por operación
+    ios::fmtflags formato = out.flags();
+    out << left << setw(18) << "operacion" << right << setw(12) << "llamadas" << setw(10) << "muestras"
+        << setw(10) << "prom_ns" << setw(10) << "p50_ns" << setw(10) << "p90_ns"
+        << setw(10) << "p99_ns" << setw(12) << "max_ns" << endl;
+    for (int op = 0; op < MET_TOTAL_OPERACIONES; ++op) {
+        const HistogramaLatencia& h = total.ops[op];
+        if (h.llamadas == 0) continue;
+        out << left << setw(18) << NOMBRES_METRICAS[op] << right << setw(12) << h.llamadas
+            << setw(10) << h.muestras << setw(10) << (h.muestras ? h.sumaNs / h.muestras : 0)
+            << setw(10) << percentilLatencia(h, 50) << setw(10) << percentilLatencia(h, 90)
+            << setw(10) << percentilLatencia(h, 99) << setw(12) << h.maxNs << endl;
+    }
+    for (int c = 0; c < CNT_TOTAL_CONTADORES; ++c) {
+        out << NOMBRES_CONTADORES[c] << ": " << total.contadores[c] << endl;
+    }
+    out.flags(formato);
+#else
+    out << "Métricas deshabilitadas (compile con -DALPHATECH_METRICAS)" << endl;
+#endif
+}
+
+// Vuelca las métricas a un archivo de texto
+bool volcarMetricas(const char* nombreArchivo) {
+    ofstream archivo(nombreArchivo);
+    if (!archivo.is_open()) {
+        cout << "✗ Error: No se pudo crear el archivo " << nombreArchivo << endl;
+        return false;
+    }
+    volcarMetricas(archivo);
+    return true;
+}
+
+/*======================================================================================
+FUNCIONES AUXILIARES DE UTILIDAD
+======================================================================================
+Estas funciones proporcionan utilidades adicionales para el manejo del sistema:
+- Limpiar pantalla para mejor presentación
+- Pausar ejecución para lectura
+- Mostrar ayuda del sistema
+======================================================================================*/
+
+// Función para pausar y esperar input del usuario
+void pausar() {
+    cout << "\nPresione ENTER para continuar...";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    cin.get();
+}
+
+// Mostrar ayuda del sistema
+void mostrarAyuda() {
+    cout << "\n=== GUÍA RÁPIDA DEL SISTEMA ALPHATECH ===" << endl;
+    cout << "\nFUNCIONES PRINCIPALES:" << endl;
+    cout << "• Crear almacén: Define las dimensiones de tu almacén (grandes = modo disperso)" << endl;
+    cout << "• Colocar lotes: Asigna componentes a posiciones específicas" << endl;
+    cout << "• Recibir camión: Coloca muchos lotes de una vez (todos o ninguno)" << endl;
+    cout << "• Inspecciones: Lleva control de calidad con historial" << endl;
+    cout << "• Búsquedas: Localiza componentes por nombre o ID" << endl;
+    cout << "• Reportes: Consulta estadísticas y estados del almacén" << endl;
+    
+    cout << "\nALERTAS AUTOMÁTICAS:" << endl;
+    cout << "• Almacén >75% ocupado: Advertencia de capacidad" << endl;
+    cout << "• Almacén >90% ocupado: Alerta crítica" << endl;
+    cout << "• Stock bajo: Componentes con ≤10 unidades" << endl;
+    cout << "• Alta tasa rechazo: >20% inspecciones rechazadas" << endl;
+    
+    cout << "\nGESTIÓN DE DATOS:" << endl;
+    cout << "• Diario automático: Cada operación se registra y se recupera al reiniciar" << endl;
+    cout << "• Backup: Guarda el estado completo y reinicia el diario" << endl;
+    cout << "• Exportar/Importar: Intercambio de datos" << endl;
+    cout << "• Restauración: Recupera desde backups" << endl;
+    
+    cout << "\nCONSEJOS DE USO:" << endl;
+    cout << "• IDs únicos: Cada lote debe tener un ID diferente" << endl;
+    cout << "• Posiciones: Coordenadas empiezan en (0,0)" << endl;
+    cout << "• Historial: Máximo " << PILA_CAPACIDAD << " inspecciones en memoria (todas quedan en la bitácora)" << endl;
+    cout << "• Validación: El sistema verifica todas las entradas" << endl;
+}
+
+// Recepción de un camión desde el menú: pide los lotes y los coloca en bloque
+void recibirCamion(Almacen& A, Maestro& maestro, Diario& D) {
+    int n = validarEntero("Cantidad de lotes del camión (1-1000): ", 1, 1000);
+    cout << "Políticas: 1) Llenar filas  2) Agrupar por componente  3) Cerca del muelle" << endl;
+    int politica = validarEntero("Política (1-3): ", 1, 3) - 1;
+    int fm = 0, cm = 0;
+    if (politica == POLITICA_MUELLE) {
+        cout << "Fila del muelle (0-" << (A.filas - 1) << "): ";
+        fm = validarEntero("", 0, A.filas - 1);
+        cout << "Columna del muelle (0-" << (A.columnas - 1) << "): ";
+        cm = validarEntero("", 0, A.columnas - 1);
+    }
+    
+    vector<LoteProduccion> lotes(n);
+    for (int i = 0; i < n; ++i) {
+        LoteProduccion& lote = lotes[i];
+        memset(&lote, 0, sizeof(lote));
+        cout << "--- Lote " << (i + 1) << " de " << n << " ---" << endl;
+        lote.idLote = validarEntero("Ingrese el ID del lote (positivo): ", 1, 99999);
+        validarString("Ingrese el nombre del componente: ", lote.nombreComponente, NOMBRE_MAX);
+        lote.pesoUnitario = validarFloat("Ingrese el peso unitario (kg): ", 0.001f, 1000.0f);
+        lote.cantidadTotal = validarEntero("Ingrese la cantidad total: ", 1, 100000);
+    }
+    
+    vector<int> celdas(n);
+    int fallido;
+    int resultado = colocarLotes(A, maestro, lotes.data(), n, politica, fm, cm, celdas.data(), fallido);
+    if (resultado == LOTES_ID_DUPLICADO) {
+        cout << "✗ Error: El ID " << lotes[fallido].idLote << " está repetido o ya existe. No se colocó ningún lote." << endl;
+    } else if (resultado == LOTES_LLENO) {
+        cout << "✗ Error: No hay " << n << " posiciones libres. No se colocó ningún lote." << endl;
+    } else if (resultado != LOTES_OK) {
+        cout << "✗ Error: Datos inválidos. No se colocó ningún lote." << endl;
+    } else {
+        diarioAnotarLotes(D, A, maestro, lotes.data(), celdas.data(), n);
+        for (int i = 0; i < n; ++i) {
+            cout << "  Lote " << lotes[i].idLote << " -> (" << celdas[i] / A.columnas << ", "
+                 << celdas[i] % A.columnas << ")" << endl;
+        }
+        cout << "✓ " << n << " lotes colocados exitosamente" << endl;
+    }
+}
+
+/*======================================================================================
+MODO POR LOTES (SIN MENÚ): alphatech --batch [archivo]
+======================================================================================
+Lee comandos línea por línea (de un archivo o de la entrada estándar si se omite o es
+"-") y responde una línea por comando en la salida estándar:
+  INIT f c                      -> OK                  (almacén nuevo)
+  RESIZE f c                    -> OK <lotes fuera>
+  PLACE f c id nombre peso cant -> OK
+  PLACE f c id                  -> OK                  (lote registrado sin posición)
+  RECEIVE política n [f c]      -> OK <n> <id>:<f>,<c> ...   (colocación en bloque)
+    seguido de n líneas "id nombre peso cant"; política: ROWS, COMPONENT o DOCK (con
+    el muelle f c). Se colocan todos los lotes o ninguno (ver COLOCACIÓN EN BLOQUE)
+  INSPECT id resultado          -> OK <aprobadas ventana> <inspecciones ventana>
+  UNDO                          -> OK <id> <resultado>
+  MOVE fo co fd cd              -> OK
+  REMOVE id                     -> OK                  (también lotes sin posición)
+  QUERY ID id                   -> OK <id> <f> <c> <nombre> <peso> <cant>  (f=c=-1 sin colocar)
+  QUERY NAME nombre             -> OK <k> <id>:<f>,<c> ...
+  QUERY ROW f                   -> OK <k> <unidades> <peso> <c>:<id> ...
+  QUERY RECT f0 c0 f1 c1        -> OK <k> <id>:<f>,<c> ...   (rectángulo inclusivo)
+  QUERY NEAR f c k nombre       -> OK <k> <id>:<f>,<c> ...   (k más cercanos, Manhattan)
+  QUERY FREE f c                -> OK <f> <c>          (celda libre más cercana)
+  QUERY STATS                   -> OK <filas> <columnas> <ocupadas> <lotes> <unidades> <peso>
+  QUERY RATE id                 -> OK <aprobadas ventana> <inspecciones ventana> <total>
+  METRICS [archivo]             -> OK                  (vuelca las métricas a un archivo)
+  REPORT formato archivo        -> OK <lotes>          (reporte completo a un archivo)
+  REPORT formato archivo ROW f  -> OK <lotes>
+  REPORT formato archivo NAME nombre -> OK <lotes>
+    formato: TEXT, TABLE, CSV o JSON (ver MOTOR DE REPORTES)
+Errores: ERR <línea> <CÓDIGO>. Las líneas vacías y las que empiezan con '#' se ignoran.
+Si el diario de operaciones falla, los comandos que modifican el almacén (INIT, RESIZE,
+PLACE, RECEIVE, MOVE, REMOVE) responden ERR <línea> DIARIO sin aplicar nada.
+Si la bitácora de inspecciones no se puede escribir, INSPECT responde ERR <línea> ARCHIVO.
+Usa las mismas funciones que el menú, con el mismo diario y bitácora; la salida se
+acumula en un búfer y los mensajes del núcleo van a la salida de errores. Las respuestas
+se entregan cada vez que la entrada se queda sin líneas completas (así se puede dialogar
+comando a comando por una tubería o FIFO) o se llena el búfer, y siempre después de
+confirmar en disco el diario y la bitácora: un OK entregado ya no se pierde con un corte.
+======================================================================================*/
+const int DIARIO_GRUPO_LOTE = 4096;           // Registros por fsync en modo por lotes
+const int MAX_CAMPOS_COMANDO = 16;
+
+// Separa una línea en campos por espacios o tabuladores
+int separarCampos(string_view linea, string_view campos[MAX_CAMPOS_COMANDO]) {
+    int n = 0;
+    size_t i = 0;
+    while (n < MAX_CAMPOS_COMANDO) {
+        while (i < linea.size() && (linea[i] == ' ' || linea[i] == '\t')) i++;
+        if (i == linea.size()) break;
+        size_t ini = i;
+        while (i < linea.size() && linea[i] != ' ' && linea[i] != '\t') i++;
+        campos[n++] = linea.substr(ini, i - ini);
+    }
+    return n;
+}
+
+// Une los campos [desde, hasta) en un nombre terminado en '\0' (con un espacio entre campos)
+bool unirNombre(string_view linea, const string_view& desde, const string_view& hasta, char* nombre) {
+    string_view t = linea.substr(desde.data() - linea.data(), hasta.data() + hasta.size() - desde.data());
+    if (t.empty() || t.size() >= (size_t)NOMBRE_MAX) return false;
+    memcpy(nombre, t.data(), t.size());
+    nombre[t.size()] = '\0';
+    return true;
+}
+
+// Ejecuta un comando; devuelve nullptr si tuvo éxito o el código de error
+// Las respuestas OK escriben sus datos tras "OK" en S; RECEIVE lee sus lotes de L
+const char* ejecutarComando(string_view linea, Almacen*& A, Maestro& maestro, Pila& pila,
+                            Diario& D, BitacoraInspecciones& B, SalidaLote& S, LectorLineas& L) {
+    string_view c[MAX_CAMPOS_COMANDO];
+    int n = separarCampos(linea, c);
+    int a1, a2, a3, a4;
+    
+    // Sin diario no se confirma ningún cambio (RECEIVE consume antes sus lotes)
+    if (D.error && (c[0] == "INIT" || c[0] == "RESIZE" || c[0] == "PLACE"
+                    || c[0] == "MOVE" || c[0] == "REMOVE")) return "DIARIO";
+    
+    if (c[0] == "INIT") {
+        if (n != 3 || !leerNumero(c[1], a1) || !leerNumero(c[2], a2)) return "SINTAXIS";
+        if (a1 < 1 || a1 > MAX_DIMENSION || a2 < 1 || a2 > MAX_DIMENSION) return "DIMENSION";
+        if (A) {
+            liberarAlmacen(A);
+            maestroDesubicar(maestro);
+        }
+        A = crearAlmacen(a1, a2);
+        diarioAnotar(D, DIARIO_ALMACEN, a1, a2);
+        salidaTexto(S, "OK\n");
+        return nullptr;
+    }
+    if (c[0] == "RESIZE") {
+        if (n != 3 || !leerNumero(c[1], a1) || !leerNumero(c[2], a2)) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        if (a1 < 1 || a1 > MAX_DIMENSION || a2 < 1 || a2 > MAX_DIMENSION) return "DIMENSION";
+        vector<int> fuera;
+        redimensionarAlmacen(A, maestro, a1, a2, fuera);
+        diarioAnotar(D, DIARIO_REDIMENSIONAR, a1, a2);
+        salidaTexto(S, "OK ");
+        salidaNumero(S, fuera.size());
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[0] == "PLACE" && n == 4) {
+        // PLACE f c id: vuelve a colocar un lote que quedó sin posición
+        if (!leerNumero(c[1], a1) || !leerNumero(c[2], a2) || !leerNumero(c[3], a3)) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        int slot = maestroBuscarID(maestro, a3);
+        if (slot == -1) return "NO_EXISTE";
+        if (maestroCelda(maestro, slot) != -1) return "ID_DUPLICADO";
+        if (!almacenDentro(*A, a1, a2) || almacenOcupadaFC(*A, a1, a2)) return "POSICION";
+        ubicarLote(*A, maestro, a3, a1, a2);
+        diarioAnotar(D, DIARIO_COLOCAR, a3, a1, a2, 0, &maestro, slot);
+        salidaTexto(S, "OK\n");
+        return nullptr;
+    }
+    if (c[0] == "PLACE") {
+        // PLACE f c id nombre... peso cant (el nombre puede tener espacios)
+        char nombre[NOMBRE_MAX];
+        float peso;
+        if (n < 7 || !leerNumero(c[1], a1) || !leerNumero(c[2], a2) || !leerNumero(c[3], a3)
+            || !leerNumero(c[n - 2], peso) || !leerNumero(c[n - 1], a4)
+            || !unirNombre(linea, c[4], c[n - 3], nombre)) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        if (a3 < 1 || peso <= 0.0f || a4 < 1) return "VALOR";
+        if (!almacenDentro(*A, a1, a2) || almacenOcupadaFC(*A, a1, a2)) return "POSICION";
+        int slot = maestroCrear(maestro, a3, nombre, peso, a4);
+        if (slot == -1) return "ID_DUPLICADO";
+        colocar(*A, maestro, a1, a2, slot);
+        diarioAnotar(D, DIARIO_COLOCAR, a3, a1, a2, 0, &maestro, slot);
+        salidaTexto(S, "OK\n");
+        return nullptr;
+    }
+    if (c[0] == "RECEIVE") {
+        // RECEIVE política n [f c], seguido de n líneas "id nombre... peso cant"
+        int politica = c[1] == "ROWS" ? POLITICA_FILAS : c[1] == "COMPONENT" ? POLITICA_COMPONENTE
+                     : c[1] == "DOCK" ? POLITICA_MUELLE : -1;
+        bool muelle = (politica == POLITICA_MUELLE);
+        a2 = a3 = 0;
+        if (n < 3 || politica == -1 || !leerNumero(c[2], a1) || a1 < 1 || n != (muelle ? 5 : 3)
+            || (muelle && (!leerNumero(c[3], a2) || !leerNumero(c[4], a3)))) return "SINTAXIS";
+        
+        // Leer los n lotes (siempre todos, para no desincronizar los comandos siguientes)
+        vector<LoteProduccion> lotes;
+        lotes.reserve(min(a1, 1 << 16));
+        bool sintaxis = true;
+        string_view l;
+        while ((int)lotes.size() < a1 && leerLinea(L, l)) {
+            l = recortar(l);
+            if (l.empty() || l[0] == '#') continue;
+            string_view d[MAX_CAMPOS_COMANDO];
+            int m = separarCampos(l, d);
+            LoteProduccion lote;
+            memset(&lote, 0, sizeof(lote));
+            sintaxis = sintaxis && m >= 4 && leerNumero(d[0], lote.idLote)
+                    && leerNumero(d[m - 2], lote.pesoUnitario) && leerNumero(d[m - 1], lote.cantidadTotal)
+                    && unirNombre(l, d[1], d[m - 3], lote.nombreComponente);
+            lotes.push_back(lote);
+        }
+        if (!sintaxis || (int)lotes.size() < a1) return "SINTAXIS";
+        if (D.error) return "DIARIO";
+        if (!A) return "SIN_ALMACEN";
+        
+        vector<int> celdas(a1);
+        int fallido;
+        switch (colocarLotes(*A, maestro, lotes.data(), a1, politica, a2, a3, celdas.data(), fallido)) {
+            case LOTES_VALOR: return "VALOR";
+            case LOTES_ID_DUPLICADO: return "ID_DUPLICADO";
+            case LOTES_LLENO: return "LLENO";
+            case LOTES_POSICION: return "POSICION";
+            default: break;
+        }
+        diarioAnotarLotes(D, *A, maestro, lotes.data(), celdas.data(), a1);
+        salidaTexto(S, "OK ");
+        salidaNumero(S, a1);
+        for (int i = 0; i < a1; ++i) {
+            salidaTexto(S, " ");
+            salidaNumero(S, lotes[i].idLote);
+            salidaTexto(S, ":");
+            salidaNumero(S, celdas[i] / A->columnas);
+            salidaTexto(S, ",");
+            salidaNumero(S, celdas[i] % A->columnas);
+        }
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[0] == "INSPECT") {
+        if (n != 3 || !leerNumero(c[1], a1) || !leerNumero(c[2], a2)) return "SINTAXIS";
+        if (a2 != 0 && a2 != 1) return "VALOR";
+        int slot = maestroBuscarID(maestro, a1);
+        if (slot == -1) return "NO_EXISTE";
+        // Primero la bitácora: la pila no debe tener una inspección que la bitácora no tiene
+        if (B.datos && !bitacoraRegistrar(B, a1, a2, maestroNombre(maestro, slot))) return "ARCHIVO";
+        pilaPush(pila, a1, a2);
+        const SerieInspecciones* s = bitacoraSerieLote(B, a1);
+        salidaTexto(S, "OK ");
+        salidaNumero(S, s ? s->aprobadasVentana : a2);
+        salidaTexto(S, " ");
+        salidaNumero(S, s ? serieVentana(*s) : 1);
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[0] == "UNDO") {
+        if (n != 1) return "SINTAXIS";
+        if (!pilaPop(pila, a1, a2)) return "VACIA";
+        bitacoraDeshacer(B);
+        salidaTexto(S, "OK ");
+        salidaNumero(S, a1);
+        salidaTexto(S, a2 ? " 1\n" : " 0\n");
+        return nullptr;
+    }
+    if (c[0] == "MOVE") {
+        if (n != 5 || !leerNumero(c[1], a1) || !leerNumero(c[2], a2)
+            || !leerNumero(c[3], a3) || !leerNumero(c[4], a4)) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        if (!moverLote(*A, maestro, a1, a2, a3, a4)) return "POSICION";
+        diarioAnotar(D, DIARIO_MOVER, a1, a2, a3, a4);
+        salidaTexto(S, "OK\n");
+        return nullptr;
+    }
+    if (c[0] == "REMOVE") {
+        if (n != 2 || !leerNumero(c[1], a1)) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        if (!removerLote(*A, maestro, a1)) return "NO_EXISTE";
+        diarioAnotar(D, DIARIO_REMOVER, a1);
+        salidaTexto(S, "OK\n");
+        return nullptr;
+    }
+    if (c[0] == "METRICS") {
+        if (n > 2) return "SINTAXIS";
+        string nombreArchivo = n == 2 ? string(c[1]) : string(ARCHIVO_METRICAS);
+        if (!volcarMetricas(nombreArchivo.c_str())) return "ARCHIVO";
+        salidaTexto(S, "OK\n");
+        return nullptr;
+    }
+    if (c[0] == "REPORT") {
+        // REPORT formato archivo [ROW f | NAME nombre...]
+        FormatoReporte formato;
+        char nombre[NOMBRE_MAX];
+        if (n < 3 || !leerFormatoReporte(c[1], formato)) return "SINTAXIS";
+        bool porFila = n >= 4 && c[3] == "ROW";
+        bool porNombre = n >= 4 && c[3] == "NAME";
+        if (n > 3 && !porFila && !porNombre) return "SINTAXIS";
+        if (porFila && (n != 5 || !leerNumero(c[4], a1))) return "SINTAXIS";
+        if (porNombre && (n < 5 || !unirNombre(linea, c[4], c[n - 1], nombre))) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        if (porFila && (a1 < 0 || a1 >= A->filas)) return "POSICION";
+        string nombreArchivo(c[2]);
+        SalidaLote R;
+        if (!salidaAbrirArchivo(R, nombreArchivo.c_str())) return "ARCHIVO";
+        int lotes = porFila ? reporteFila(*A, maestro, a1, R, formato)
+                  : porNombre ? buscarPorNombre(*A, maestro, nombre, R, formato)
+                  : reporteCompleto(*A, maestro, R, formato);
+        if (!salidaCerrarArchivo(R)) return "ARCHIVO";
+        salidaTexto(S, "OK ");
+        salidaNumero(S, lotes);
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[0] != "QUERY" || n < 2) return "COMANDO";
+    
+    // Consultas (no modifican el estado)
+    if (c[1] == "ID") {
+        if (n != 3 || !leerNumero(c[2], a1)) return "SINTAXIS";
+        int slot = maestroBuscarID(maestro, a1);
+        if (slot == -1) return "NO_EXISTE";
+        int celda = maestroCelda(maestro, slot);
+        salidaTexto(S, "OK ");
+        salidaNumero(S, maestroId(maestro, slot));
+        salidaTexto(S, " ");
+        salidaNumero(S, (celda == -1 || !A) ? -1 : celda / A->columnas);
+        salidaTexto(S, " ");
+        salidaNumero(S, (celda == -1 || !A) ? -1 : celda % A->columnas);
+        salidaTexto(S, " ");
+        salidaTexto(S, maestroNombre(maestro, slot));
+        salidaTexto(S, " ");
+        salidaDecimal(S, maestroPeso(maestro, slot));
+        salidaTexto(S, " ");
+        salidaNumero(S, maestroCantidad(maestro, slot));
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[1] == "NAME") {
+        char nombre[NOMBRE_MAX];
+        if (n < 3 || !unirNombre(linea, c[2], c[n - 1], nombre)) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        vector<int> celdas;
+        int nid = nombresBuscar(maestro.nombres, nombre);
+        if (nid != -1) celdasPorNombre(maestro, nid, celdas);
+        sort(celdas.begin(), celdas.end());
+        salidaTexto(S, "OK ");
+        salidaNumero(S, celdas.size());
+        for (int idx : celdas) {
+            salidaTexto(S, " ");
+            salidaNumero(S, maestroId(maestro, almacenSlot(*A, idx)));
+            salidaTexto(S, ":");
+            salidaNumero(S, idx / A->columnas);
+            salidaTexto(S, ",");
+            salidaNumero(S, idx % A->columnas);
+        }
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[1] == "ROW") {
+        if (n != 3 || !leerNumero(c[2], a1)) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        if (a1 < 0 || a1 >= A->filas) return "POSICION";
+        vector<int> celdas;
+        almacenOcupadas(*A, a1, a1 + 1, celdas);
+        salidaTexto(S, "OK ");
+        salidaNumero(S, A->ocupadasFila[a1]);
+        salidaTexto(S, " ");
+        salidaNumero(S, A->unidadesFila[a1]);
+        salidaTexto(S, " ");
+        salidaDecimal(S, A->pesoFila[a1]);
+        for (int idx : celdas) {
+            salidaTexto(S, " ");
+            salidaNumero(S, idx % A->columnas);
+            salidaTexto(S, ":");
+            salidaNumero(S, maestroId(maestro, almacenSlot(*A, idx)));
+        }
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[1] == "RECT" || c[1] == "NEAR") {
+        // Consultas espaciales: misma respuesta que NAME, en el orden de la consulta
+        vector<int> celdas;
+        if (c[1] == "RECT") {
+            if (n != 6 || !leerNumero(c[2], a1) || !leerNumero(c[3], a2)
+                || !leerNumero(c[4], a3) || !leerNumero(c[5], a4)) return "SINTAXIS";
+            if (!A) return "SIN_ALMACEN";
+            almacenRango(*A, a1, a2, a3, a4, celdas);
+        } else {
+            char nombre[NOMBRE_MAX];
+            if (n < 6 || !leerNumero(c[2], a1) || !leerNumero(c[3], a2) || !leerNumero(c[4], a3)
+                || !unirNombre(linea, c[5], c[n - 1], nombre)) return "SINTAXIS";
+            if (!A) return "SIN_ALMACEN";
+            if (!almacenDentro(*A, a1, a2)) return "POSICION";
+            if (a3 < 1) return "VALOR";
+            int nid = nombresBuscar(maestro.nombres, nombre);
+            if (nid != -1) almacenCercanosComponente(*A, maestro, nid, a1, a2, a3, celdas);
+        }
+        salidaTexto(S, "OK ");
+        salidaNumero(S, celdas.size());
+        for (int idx : celdas) {
+            salidaTexto(S, " ");
+            salidaNumero(S, maestroId(maestro, almacenSlot(*A, idx)));
+            salidaTexto(S, ":");
+            salidaNumero(S, idx / A->columnas);
+            salidaTexto(S, ",");
+            salidaNumero(S, idx % A->columnas);
+        }
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[1] == "FREE") {
+        if (n != 4 || !leerNumero(c[2], a1) || !leerNumero(c[3], a2)) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        if (!almacenDentro(*A, a1, a2)) return "POSICION";
+        int fl, cl;
+        if (!almacenLibreMasCercana(*A, a1, a2, fl, cl)) return "LLENO";
+        salidaTexto(S, "OK ");
+        salidaNumero(S, fl);
+        salidaTexto(S, " ");
+        salidaNumero(S, cl);
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[1] == "STATS") {
+        if (n != 2) return "SINTAXIS";
+        if (!A) return "SIN_ALMACEN";
+        salidaTexto(S, "OK ");
+        salidaNumero(S, A->filas);
+        salidaTexto(S, " ");
+        salidaNumero(S, A->columnas);
+        salidaTexto(S, " ");
+        salidaNumero(S, A->ocupadas);
+        salidaTexto(S, " ");
+        salidaNumero(S, maestro.size);
+        salidaTexto(S, " ");
+        salidaNumero(S, A->unidades);
+        salidaTexto(S, " ");
+        salidaDecimal(S, A->peso);
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    if (c[1] == "RATE") {
+        if (n != 3 || !leerNumero(c[2], a1)) return "SINTAXIS";
+        const SerieInspecciones* s = bitacoraSerieLote(B, a1);
+        salidaTexto(S, "OK ");
+        salidaNumero(S, s ? s->aprobadasVentana : 0);
+        salidaTexto(S, " ");
+        salidaNumero(S, s ? serieVentana(*s) : 0);
+        salidaTexto(S, " ");
+        salidaNumero(S, s ? s->posiciones.size() : 0);
+        salidaTexto(S, "\n");
+        return nullptr;
+    }
+    return "COMANDO";
+}
+
+// Estado que las respuestas deben confirmar antes de salir
+struct ConfirmacionLote {
+    Diario* D;
+    BitacoraInspecciones* B;
+};
+
+// Confirma en disco el diario y la bitácora (se llama antes de escribir respuestas)
+void confirmarLote(void* contexto) {
+    ConfirmacionLote* c = static_cast<ConfirmacionLote*>(contexto);
+    diarioSincronizar(*c->D);
+    bitacoraSincronizar(*c->B);
+}
+
+// Ejecuta todos los comandos de la entrada
+// RETORNA: 0 si todos tuvieron éxito, 1 si alguno falló
+int ejecutarLote(istream& entrada, Almacen*& A, Maestro& maestro, Pila& pila,
+                 Diario& D, BitacoraInspecciones& B) {
+    ConfirmacionLote confirmacion = {&D, &B};
+    SalidaLote S;
+    salidaInit(S, stdout);
+    S.antesDeEscribir = confirmarLote;
+    S.contexto = &confirmacion;
+    
+    LectorLineas L;
+    lectorInit(L, entrada);
+    L.salida = &S;
+#ifdef ALPHATECH_MMAP
+    if (&entrada == &cin) L.fd = STDIN_FILENO;  // read() devuelve lo que haya llegado
+#endif
+    string_view linea;
+    long long comandos = 0, errores = 0;
+    while (leerLinea(L, linea)) {
+        linea = recortar(linea);
+        if (linea.empty() || linea[0] == '#') continue;
+        comandos++;
+        int numLinea = L.numLinea;
+        const char* error = ejecutarComando(linea, A, maestro, pila, D, B, S, L);
+        if (error) {
+            errores++;
+            salidaTexto(S, "ERR ");
+            salidaNumero(S, numLinea);
+            salidaTexto(S, " ");
+            salidaTexto(S, error);
+            salidaTexto(S, "\n");
+        }
+        // Mantenimiento periódico: confirmación en grupo y compactación del diario
+        if ((comandos & (DIARIO_GRUPO_LOTE - 1)) == 0) {
+            diarioMantenimiento(A, maestro, D);
+            bitacoraSincronizar(B);
+        }
+    }
+    lectorFree(L);
+    
+    diarioMantenimiento(A, maestro, D);
+    bitacoraSincronizar(B);
+    salidaFree(S);
+    cerr << "Lote: " << comandos << " comandos, " << errores << " errores" << endl;
+    return errores ? 1 : 0;
+}
+
+/*======================================================================================
+MODO DE MEDICIÓN: alphatech --bench [completo]
+======================================================================================
+Mide las operaciones del núcleo sobre varios tamaños de almacén y niveles de ocupación
+y escribe los resultados en JSON por la salida estándar (ns por operación), para
+comparar versiones. No toca el estado persistente: usa archivos temporales propios.
+- Por configuración: maestroCrear, colocar, maestroBuscarID, moverLote, consultas
+  espaciales (almacenRango, almacenCercanosComponente, almacenLibreMasCercana),
+  colocarLotes por política contra uno a uno (camión de 500 lotes, ns por lote),
+  buscarPorNombre, reporteFila, reporteCompleto y reporteCompleto/json (ns por lote),
+  mostrarEstadisticas, verificarStockBajo (ns por lote), removerLote;
+  exportarDatos/importarDatos y snapshot binario (guardar/cargar) hasta 500.000 lotes
+- Denso contra disperso con la misma ocupación
+- Rotación del maestro: lista libre contra la búsqueda lineal de un slot libre
+- Kernels de columnas (filtrarHasta, sumarColocados) sobre 1.000.000 de lotes, una
+  entrada por variante soportada (escalar, sse2, avx2), en ns por lote
+- Registros de 1.000.000 de lotes: LoteProduccion contra LoteCompacto (conversión,
+  recorrido y armado desde el maestro), en ns por lote
+- Disposición del arreglo DENSO (filas contra bloques de 4x4) en 1.000 x 1.000 y
+  4.000 x 4.000: recorridos por filas, columnas y bloques de 64 x 64 (ns por celda) y
+  los 4 vecinos de celdas al azar (ns por consulta)
+- pilaPush con capacidad 10, 1.000 y 1.000.000
+"completo" agrega el almacén denso de 10.000 x 10.000 (~400 MB de slots).
+La salida de las funciones que imprimen se descarta en un búfer en memoria.
+Compilar como para producción: g++ -std=c++17 -O2 -DNDEBUG -pthread, sin
+-DALPHATECH_VERIFICAR (con el verificador cada mostrarEstadisticas recorre el almacén
+y el maestro completos y la medición deja de ser la de la operación O(1)).
 ======================================================================================*/
-struct Pila {
-    int id[10];     // IDs de lotes inspeccionados
-    int res[10];    // Resultados: 1=aprobado, 0=rechazado
-    int top;        // Índice del tope (-1 si vacía)
+const char* const ARCHIVO_MEDICION_CSV = "medicion_tmp.csv";
+const char* const ARCHIVO_MEDICION_BIN = "medicion_tmp.bin";
+const int NOMBRES_MEDICION = 500;      // Componentes distintos en los lotes de prueba
+const int MAX_LOTES_ARCHIVO = 500000;  // Límite para medir exportación/importación
+
+typedef chrono::steady_clock Reloj;
+
+struct ConfigMedicion {
+    int filas, columnas;
+    int ocupacion;   // Porcentaje de celdas ocupadas
+    int modo;        // ALMACEN_AUTO / DENSO / DISPERSO
+    int capacidad;   // Lotes del maestro o capacidad de la pila (mediciones sin almacén)
 };
 
-// Inicializa la pila vacía
-void pilaInit(Pila& p) { 
-    p.top = -1; 
-}
+// Destino de los resultados que no se usan, para que el compilador no elimine el trabajo
+volatile long long sumideroMedicion = 0;
 
-// Verifica si la pila está vacía
-bool pilaVacia(const Pila& p) { 
-    return p.top < 0; 
-}
+struct Medicion {
+    string nombre;
+    ConfigMedicion cfg;
+    long long operaciones;
+    double ns;       // Tiempo total
+};
 
-// Agrega una inspección a la pila
-void pilaPush(Pila& p, int idLote, int resultado) {
-    if (p.top < 9) { 
-        p.top++;
-        p.id[p.top] = idLote;
-        p.res[p.top] = resultado;
-    } else {         
-        // Pila llena: desplaza elementos y agrega al final
-        for (int i = 0; i < 9; ++i) { 
-            p.id[i] = p.id[i+1]; 
-            p.res[i] = p.res[i+1]; 
-        }
-        p.id[9] = idLote; 
-        p.res[9] = resultado;
+// Descarta lo que se escribe en él, pero con búfer (como una salida real)
+class SumideroSalida : public streambuf {
+    char buf[1 << 12];
+public:
+    SumideroSalida() { setp(buf, buf + sizeof(buf)); }
+protected:
+    int overflow(int c) override {
+        setp(buf, buf + sizeof(buf));
+        return c;
     }
+};
+
+double nsDesde(Reloj::time_point t0) {
+    return (double)chrono::duration_cast<chrono::nanoseconds>(Reloj::now() - t0).count();
 }
 
-// Remueve la última inspección de la pila
-bool pilaPop(Pila& p, int& idLote, int& resultado) {
-    if (pilaVacia(p)) return false;
-    idLote = p.id[p.top];
-    resultado = p.res[p.top];
-    p.top--;
-    return true;
+// Generador pseudoaleatorio reproducible (xorshift64)
+inline uint64_t aleatorio(uint64_t& estado) {
+    estado ^= estado << 13;
+    estado ^= estado >> 7;
+    estado ^= estado << 17;
+    return estado;
 }
 
-// Mostrar todo el historial de inspecciones
-void mostrarHistorialInspecciones(const Pila& p, const Maestro& maestro) {
-    cout << "\n=== HISTORIAL COMPLETO DE INSPECCIONES ===" << endl;
+void medicionAgregar(vector<Medicion>& R, const string& nombre, const ConfigMedicion& cfg, long long n, double ns) {
+    R.push_back(Medicion{nombre, cfg, n, ns});
+}
+
+// Mide todas las operaciones del almacén para una configuración
+void medirAlmacen(const ConfigMedicion& cfg, vector<Medicion>& R) {
+    uint64_t semilla = 88172645463325252ull;
+    long long N = (long long)cfg.filas * cfg.columnas;
+    int lotes = (int)(N * cfg.ocupacion / 100);
     
-    if (pilaVacia(p)) {
-        cout << "No hay inspecciones registradas." << endl;
-        return;
+    // Celdas a ocupar: permutación si el área es pequeña, sorteo con reintento si no
+    vector<int> celdas;
+    celdas.reserve(lotes);
+    if (N <= (1 << 22)) {
+        vector<int> todas(N);
+        for (int i = 0; i < N; ++i) todas[i] = i;
+        for (int i = 0; i < lotes; ++i) swap(todas[i], todas[i + aleatorio(semilla) % (N - i)]);
+        celdas.assign(todas.begin(), todas.begin() + lotes);
+    } else {
+        vector<uint64_t> usadas((N + 63) / 64, 0);
+        while ((int)celdas.size() < lotes) {
+            int idx = (int)(aleatorio(semilla) % N);
+            if (usadas[idx >> 6] >> (idx & 63) & 1) continue;
+            usadas[idx >> 6] |= 1ull << (idx & 63);
+            celdas.push_back(idx);
+        }
     }
+    char nombres[NOMBRES_MEDICION][NOMBRE_MAX];
+    for (int i = 0; i < NOMBRES_MEDICION; ++i) snprintf(nombres[i], NOMBRE_MAX, "COMP-%03d", i);
     
-    cout << "Total de inspecciones: " << (p.top + 1) << endl;
-    cout << "----------------------------------------" << endl;
+    // maestroCrear y colocar
+    Almacen* A = crearAlmacen(cfg.filas, cfg.columnas, cfg.modo);
+    Maestro maestro;
+    maestroInit(maestro);
+    Reloj::time_point t0 = Reloj::now();
+    for (int i = 0; i < lotes; ++i) {
+        maestroCrear(maestro, i + 1, nombres[i % NOMBRES_MEDICION], 0.5f + i % 7, 1 + i % 100);
+    }
+    medicionAgregar(R, "maestroCrear", cfg, lotes, nsDesde(t0));
     
-    // Mostrar desde la más reciente (top) hasta la más antigua (0)
-    for (int i = p.top; i >= 0; i--) {
-        cout << "Inspección " << (p.top - i + 1) << ":" << endl;
-        cout << "  ID Lote: " << p.id[i] << endl;
-        
-        // Buscar información del lote en el maestro
-        int idx = maestroBuscarID(maestro, p.id[i]);
-        if (idx != -1) {
-            cout << "  Componente: " << maestro.data[idx].nombreComponente << endl;
-            cout << "  Cantidad: " << maestro.data[idx].cantidadTotal << " unidades" << endl;
-        } else {
-            cout << "  Componente: [Lote eliminado]" << endl;
+    t0 = Reloj::now();
+    for (int i = 0; i < lotes; ++i) {
+        int slot = maestroBuscarID(maestro, i + 1);
+        colocar(*A, maestro, celdas[i] / cfg.columnas, celdas[i] % cfg.columnas, slot);
+    }
+    medicionAgregar(R, "colocar", cfg, lotes, nsDesde(t0));
+    
+    // maestroBuscarID: mitad aciertos, mitad fallos
+    const int consultas = 1000000;
+    long long encontrados = 0;
+    t0 = Reloj::now();
+    for (int i = 0; i < consultas; ++i) {
+        int id = 1 + (int)(aleatorio(semilla) % (2 * (uint64_t)lotes + 1));
+        encontrados += maestroBuscarID(maestro, id) != -1;
+    }
+    medicionAgregar(R, "maestroBuscarID", cfg, consultas, nsDesde(t0));
+    
+    // moverLote: de una celda ocupada a una libre al azar
+    int movimientos = min(lotes, 200000);
+    long long intentos = 0;
+    t0 = Reloj::now();
+    for (int i = 0; i < movimientos && cfg.ocupacion < 100; ++i) {
+        int k = (int)(aleatorio(semilla) % lotes);
+        int destino;
+        do {
+            destino = (int)(aleatorio(semilla) % N);
+            intentos++;
+        } while (almacenOcupada(*A, destino));
+        moverLote(*A, maestro, celdas[k] / cfg.columnas, celdas[k] % cfg.columnas,
+                  destino / cfg.columnas, destino % cfg.columnas);
+        celdas[k] = destino;
+    }
+    medicionAgregar(R, "moverLote", cfg, movimientos, nsDesde(t0));
+    
+    // Consultas espaciales desde puntos al azar: rectángulo de 64 x 64 (un tramo de
+    // pasillo), los 10 lotes más cercanos de un componente y la celda libre más cercana
+    const int espaciales = 20000;
+    vector<int> espacio;
+    t0 = Reloj::now();
+    for (int i = 0; i < espaciales; ++i) {
+        int f = (int)(aleatorio(semilla) % cfg.filas), c = (int)(aleatorio(semilla) % cfg.columnas);
+        espacio.clear();
+        almacenRango(*A, f, c, f + 63, c + 63, espacio);
+        encontrados += espacio.size();
+    }
+    medicionAgregar(R, "almacenRango", cfg, espaciales, nsDesde(t0));
+    
+    int cercanos = max(10, min(espaciales, 20000000 / (lotes / NOMBRES_MEDICION + 1)));
+    t0 = Reloj::now();
+    for (int i = 0; i < cercanos; ++i) {
+        int f = (int)(aleatorio(semilla) % cfg.filas), c = (int)(aleatorio(semilla) % cfg.columnas);
+        int nid = nombresBuscar(maestro.nombres, nombres[i % NOMBRES_MEDICION]);
+        espacio.clear();
+        if (nid != -1) almacenCercanosComponente(*A, maestro, nid, f, c, 10, espacio);
+        encontrados += espacio.size();
+    }
+    medicionAgregar(R, "almacenCercanosComponente", cfg, cercanos, nsDesde(t0));
+    
+    t0 = Reloj::now();
+    for (int i = 0; i < espaciales; ++i) {
+        int f = (int)(aleatorio(semilla) % cfg.filas), c = (int)(aleatorio(semilla) % cfg.columnas);
+        int fl, cl;
+        encontrados += almacenLibreMasCercana(*A, f, c, fl, cl);
+    }
+    medicionAgregar(R, "almacenLibreMasCercana", cfg, espaciales, nsDesde(t0));
+    
+    // colocarLotes: un camión de hasta 500 lotes por política (se retiran después de
+    // cada medición), contra ubicar cada lote con almacenPrimeraLibre + colocar
+    int camion = (int)min<long long>(500, N - lotes);
+    if (camion > 0) {
+        vector<LoteProduccion> recibidos(camion);
+        for (int i = 0; i < camion; ++i) {
+            LoteProduccion& lote = recibidos[i];
+            memset(&lote, 0, sizeof(lote));
+            lote.idLote = 2 * lotes + 2 + i;  // Fuera de los IDs consultados arriba
+            memcpy(lote.nombreComponente, nombres[i % 20], NOMBRE_MAX);
+            lote.pesoUnitario = 0.5f + i % 7;
+            lote.cantidadTotal = 1 + i % 100;
+        }
+        vector<int> asignadas(camion);
+        const char* const nombresPolitica[] = {"colocarLotes/filas", "colocarLotes/componente",
+                                               "colocarLotes/muelle", "colocarLotes/uno_a_uno"};
+        for (int p = 0; p < 4; ++p) {
+            int fallido;
+            t0 = Reloj::now();
+            if (p <= POLITICA_MUELLE) {
+                colocarLotes(*A, maestro, recibidos.data(), camion, p, cfg.filas / 2, cfg.columnas / 2,
+                             asignadas.data(), fallido);
+            } else {
+                for (const LoteProduccion& lote : recibidos) {
+                    int f, c;
+                    almacenPrimeraLibre(*A, f, c);
+                    colocar(*A, maestro, f, c, maestroCrear(maestro, lote.idLote, lote.nombreComponente,
+                                                            lote.pesoUnitario, lote.cantidadTotal));
+                }
+            }
+            medicionAgregar(R, nombresPolitica[p], cfg, camion, nsDesde(t0));
+            for (const LoteProduccion& lote : recibidos) removerLote(*A, maestro, lote.idLote);
         }
+    }
+    
+    // Consultas que imprimen: la salida va al sumidero
+    SumideroSalida sumidero;
+    streambuf* original = cout.rdbuf(&sumidero);
+    int busquedas = max(10, min(10000, 200000 / (lotes / NOMBRES_MEDICION + 1)));
+    t0 = Reloj::now();
+    for (int i = 0; i < busquedas; ++i) buscarPorNombre(*A, maestro, nombres[i % NOMBRES_MEDICION]);
+    medicionAgregar(R, "buscarPorNombre", cfg, busquedas, nsDesde(t0));
+    
+    int reportes = max(10, min(10000, 200000 / (lotes / cfg.filas + 1)));
+    t0 = Reloj::now();
+    for (int i = 0; i < reportes; ++i) reporteFila(*A, maestro, (int)(aleatorio(semilla) % cfg.filas));
+    medicionAgregar(R, "reporteFila", cfg, reportes, nsDesde(t0));
+    
+    // Reporte completo (ns por lote listado), en texto y en JSON
+    int completos = max(1, min(100, 2000000 / (lotes + 1)));
+    t0 = Reloj::now();
+    for (int i = 0; i < completos; ++i) reporteCompleto(*A, maestro);
+    medicionAgregar(R, "reporteCompleto", cfg, (long long)completos * lotes, nsDesde(t0));
+    
+    t0 = Reloj::now();
+    for (int i = 0; i < completos; ++i) {
+        SalidaLote S;
+        salidaInitFlujo(S, &sumidero);
+        reporteCompleto(*A, maestro, S, REPORTE_JSON);
+        salidaFree(S);
+    }
+    medicionAgregar(R, "reporteCompleto/json", cfg, (long long)completos * lotes, nsDesde(t0));
+    
+    const int estadisticas = 10000;
+    t0 = Reloj::now();
+    for (int i = 0; i < estadisticas; ++i) mostrarEstadisticas(*A, maestro);
+    medicionAgregar(R, "mostrarEstadisticas", cfg, estadisticas, nsDesde(t0));
+
+    // Umbral 0: ninguna alerta, se mide solo el recorrido de la columna de cantidades
+    int verificaciones = max(10, min(1000, 100000000 / (lotes + 1)));
+    t0 = Reloj::now();
+    for (int i = 0; i < verificaciones; ++i) verificarStockBajo(*A, maestro, 0);
+    medicionAgregar(R, "verificarStockBajo", cfg, (long long)verificaciones * lotes, nsDesde(t0));
+    
+    // Exportación / importación CSV y snapshot binario (por lote)
+    if (lotes <= MAX_LOTES_ARCHIVO) {
+        t0 = Reloj::now();
+        exportarDatos(*A, maestro, ARCHIVO_MEDICION_CSV);
+        medicionAgregar(R, "exportarDatos", cfg, lotes, nsDesde(t0));
         
-        cout << "  Resultado: " << (p.res[i] ? "APROBADO" : "RECHAZADO") << endl;
-        cout << "----------------------------------------" << endl;
+        Almacen* B = nullptr;
+        Maestro maestroB;
+        maestroInit(maestroB);
+        t0 = Reloj::now();
+        importarDatos(B, maestroB, ARCHIVO_MEDICION_CSV);
+        medicionAgregar(R, "importarDatos", cfg, lotes, nsDesde(t0));
+        if (B) liberarAlmacen(B);
+        maestroFree(maestroB);
+        
+        t0 = Reloj::now();
+        guardarSnapshot(*A, maestro, ARCHIVO_MEDICION_BIN);
+        medicionAgregar(R, "guardarSnapshot", cfg, lotes, nsDesde(t0));
+        
+        B = nullptr;
+        maestroInit(maestroB);
+        t0 = Reloj::now();
+        cargarSnapshot(B, maestroB, ARCHIVO_MEDICION_BIN);
+        medicionAgregar(R, "cargarSnapshot", cfg, lotes, nsDesde(t0));
+        if (B) liberarAlmacen(B);
+        maestroFree(maestroB);
+        remove(ARCHIVO_MEDICION_CSV);
+        remove(ARCHIVO_MEDICION_BIN);
     }
+    cout.rdbuf(original);
     
-    // Estadísticas del historial
-    int aprobados = 0, rechazados = 0;
-    for (int i = 0; i <= p.top; i++) {
-        if (p.res[i] == 1) aprobados++;
-        else rechazados++;
+    // removerLote: la mitad de los lotes
+    int remociones = lotes / 2;
+    t0 = Reloj::now();
+    for (int i = 0; i < remociones; ++i) removerLote(*A, maestro, 2 * i + 1);
+    medicionAgregar(R, "removerLote", cfg, remociones, nsDesde(t0));
+    
+    sumideroMedicion = encontrados + intentos;
+    liberarAlmacen(A);
+    maestroFree(maestro);
+}
+
+// Rotación del maestro: eliminar un lote al azar y crear otro, con la lista libre
+// actual y con la búsqueda lineal del primer slot libre que usaba la versión anterior
+void medirRotacionMaestro(int lotes, vector<Medicion>& R) {
+    ConfigMedicion cfg = {0, 0, 0, ALMACEN_AUTO, lotes};
+    uint64_t semilla = 2463534242ull;
+    Maestro m;
+    maestroInit(m);
+    for (int i = 0; i < lotes; ++i) maestroCrear(m, i + 1, "COMP", 1.0f, 1);
+    
+    const int rotaciones = 200000;
+    int siguiente = lotes + 1;
+    Reloj::time_point t0 = Reloj::now();
+    for (int i = 0; i < rotaciones; ++i) {
+        int id;
+        do id = 1 + (int)(aleatorio(semilla) % (siguiente - 1)); while (maestroBuscarID(m, id) == -1);
+        maestroEliminar(m, id);
+        maestroCrear(m, siguiente++, "COMP", 1.0f, 1);
     }
+    medicionAgregar(R, "maestroRotacionListaLibre", cfg, rotaciones, nsDesde(t0));
     
-    cout << "\nESTADÍSTICAS DEL HISTORIAL:" << endl;
-    cout << "Lotes aprobados: " << aprobados << endl;
-    cout << "Lotes rechazados: " << rechazados << endl;
+    // Mismo patrón, pero el slot se busca recorriendo 'used' desde el principio
+    long long recorrido = 0;
+    t0 = Reloj::now();
+    for (int i = 0; i < rotaciones; ++i) {
+        int id;
+        do id = 1 + (int)(aleatorio(semilla) % (siguiente - 1)); while (maestroBuscarID(m, id) == -1);
+        maestroEliminar(m, id);
+        int s = 0;
+        while (s < m.cap && maestroUsado(m, s)) s++;
+        recorrido += s;
+        maestroCrear(m, siguiente++, "COMP", 1.0f, 1);
+    }
+    medicionAgregar(R, "maestroRotacionRecorrido", cfg, rotaciones, nsDesde(t0));
+    sumideroMedicion = recorrido;
+    maestroFree(m);
+}
+
+// Kernels de columnas: cada variante soportada por la CPU sobre el mismo maestro
+// (1 de cada 100 lotes bajo el umbral, la mitad colocados)
+void medirKernels(int lotes, vector<Medicion>& R) {
+    ConfigMedicion cfg = {0, 0, 0, ALMACEN_AUTO, lotes};
+    uint64_t semilla = 362436069ull;
+    Maestro m;
+    maestroInit(m);
+    for (int i = 0; i < lotes; ++i) {
+        int slot = maestroCrear(m, i + 1, "COMP", 0.5f + i % 7, 11 + (int)(aleatorio(semilla) % 1000));
+        if (i % 100 == 0) maestroCantidad(m, slot) = 5;
+        if (i % 2 == 0) maestroCelda(m, slot) = i;
+    }
     
-    if (rechazados > 0) {
-        float porcentajeRechazo = (float)rechazados / (aprobados + rechazados) * 100.0f;
-        cout << "Tasa de rechazo: " << fixed << setprecision(1) << porcentajeRechazo << "%" << endl;
+    const int pasadas = 200;
+    int* sel = new int[MAESTRO_BLOQUE];
+    for (int v = 0; v < NUM_KERNELS; ++v) {
+        const KernelsColumnas& k = KERNELS_VARIANTES[v];
+        if (!kernelsSoportados(k)) continue;
+        long long total = 0;
+        Reloj::time_point t0 = Reloj::now();
+        for (int p = 0; p < pasadas; ++p) {
+            for (int b = 0; b < m.nBloques; ++b) total += k.filtrarHasta(m.bloques[b]->cantidadTotal, MAESTRO_BLOQUE, 10, sel);
+        }
+        medicionAgregar(R, string("filtrarHasta/") + k.nombre, cfg, (long long)pasadas * m.cap, nsDesde(t0));
         
-        if (porcentajeRechazo > 20.0f) {
-            cout << "ALERTA: Alta tasa de rechazo!" << endl;
+        SumaColumnas s = {0, 0, 0.0};
+        t0 = Reloj::now();
+        for (int p = 0; p < pasadas; ++p) {
+            for (int b = 0; b < m.nBloques; ++b) {
+                const BloqueMaestro* bloque = m.bloques[b];
+                k.sumarColocados(bloque->cantidadTotal, bloque->pesoUnitario, bloque->celda, MAESTRO_BLOQUE, s);
+            }
         }
+        medicionAgregar(R, string("sumarColocados/") + k.nombre, cfg, (long long)pasadas * m.cap, nsDesde(t0));
+        sumideroMedicion = total + s.unidades;
     }
+    delete[] sel;
+    maestroFree(m);
 }
 
-/*======================================================================================
-SISTEMA DE EXPORTACIÓN/IMPORTACIÓN Y BACKUP DE DATOS
-======================================================================================
-Estas funciones permiten:
-- Exportar el estado completo del almacén a un archivo de texto
-- Importar datos previamente guardados
-- Crear backups automáticos del sistema
-- Restaurar desde backups
-======================================================================================*/
-
-// Exporta todos los datos del almacén a un archivo de texto
-bool exportarDatos(LoteProduccion** A, const Maestro& maestro, int filas, int columnas, const char* nombreArchivo) {
-    ofstream archivo(nombreArchivo);
-    if (!archivo.is_open()) {
-        cout << "✗ Error: No se pudo crear el archivo " << nombreArchivo << endl;
-        return false;
+// Registros de lote: conversión y recorrido de LoteProduccion (64 bytes) contra
+// LoteCompacto (16 bytes), y armado de cada registro desde el maestro (ns por lote)
+void medirRegistros(int lotes, vector<Medicion>& R) {
+    ConfigMedicion cfg = {0, 0, 0, ALMACEN_AUTO, lotes};
+    uint64_t semilla = 521288629ull;
+    Maestro m;
+    maestroInit(m);
+    vector<LoteProduccion> completos(lotes);
+    for (int i = 0; i < lotes; ++i) {
+        LoteProduccion& lote = completos[i];
+        memset(&lote, 0, sizeof(lote));
+        lote.idLote = i + 1;
+        snprintf(lote.nombreComponente, NOMBRE_MAX, "COMP-%03d", (int)(aleatorio(semilla) % NOMBRES_MEDICION));
+        lote.pesoUnitario = 0.5f + i % 7;
+        lote.cantidadTotal = 1 + (int)(aleatorio(semilla) % 1000);
+        maestroCrear(m, lote.idLote, lote.nombreComponente, lote.pesoUnitario, lote.cantidadTotal);
     }
     
-    cout << "Exportando datos del almacén..." << endl;
+    vector<LoteCompacto> compactos(lotes);
+    Reloj::time_point t0 = Reloj::now();
+    for (int i = 0; i < lotes; ++i) compactos[i] = loteCompactar(m.nombres, completos[i]);
+    medicionAgregar(R, "registros/compactar", cfg, lotes, nsDesde(t0));
     
-    // Escribir encabezado con metadatos
-    archivo << "# BACKUP ALMACEN ALPHATECH" << endl;
-    archivo << "# Generado automáticamente" << endl;
-    archivo << "DIMENSIONES=" << filas << "," << columnas << endl;
-    archivo << "TOTAL_LOTES=" << maestro.size << endl;
-    archivo << "# Formato: FILA,COLUMNA,ID,NOMBRE,PESO,CANTIDAD" << endl;
+    t0 = Reloj::now();
+    for (int i = 0; i < lotes; ++i) completos[i] = loteExpandir(m.nombres, compactos[i]);
+    medicionAgregar(R, "registros/expandir", cfg, lotes, nsDesde(t0));
     
-    // Exportar todos los lotes con sus posiciones
-    int lotesExportados = 0;
-    for (int f = 0; f < filas; ++f) {
-        for (int c = 0; c < columnas; ++c) {
-            int idx = f * columnas + c;
-            if (A[idx] != nullptr) {
-                archivo << f << "," << c << "," 
-                       << A[idx]->idLote << ","
-                       << A[idx]->nombreComponente << ","
-                       << fixed << setprecision(3) << A[idx]->pesoUnitario << ","
-                       << A[idx]->cantidadTotal << endl;
-                lotesExportados++;
-            }
+    // Recorrido: peso total y lotes con stock bajo (lee 8 bytes útiles por registro)
+    const int pasadas = 20;
+    double peso = 0.0;
+    long long bajos = 0;
+    t0 = Reloj::now();
+    for (int p = 0; p < pasadas; ++p) {
+        for (const LoteProduccion& lote : completos) {
+            peso += (double)lote.pesoUnitario * lote.cantidadTotal;
+            bajos += lote.cantidadTotal <= 10;
         }
     }
+    medicionAgregar(R, "registros/recorrer/LoteProduccion", cfg, (long long)pasadas * lotes, nsDesde(t0));
     
-    archivo.close();
-    cout << "✓ Datos exportados exitosamente: " << lotesExportados << " lotes guardados en " << nombreArchivo << endl;
-    return true;
-}
-
-// Importa datos desde un archivo de texto al almacén
-bool importarDatos(LoteProduccion**& A, Maestro& maestro, int& filas, int& columnas, const char* nombreArchivo) {
-    ifstream archivo(nombreArchivo);
-    if (!archivo.is_open()) {
-        cout << "✗ Error: No se pudo abrir el archivo " << nombreArchivo << endl;
-        return false;
+    t0 = Reloj::now();
+    for (int p = 0; p < pasadas; ++p) {
+        for (const LoteCompacto& lote : compactos) {
+            peso += (double)lote.pesoUnitario * lote.cantidadTotal;
+            bajos += lote.cantidadTotal <= 10;
+        }
     }
+    medicionAgregar(R, "registros/recorrer/LoteCompacto", cfg, (long long)pasadas * lotes, nsDesde(t0));
     
-    cout << "Importando datos del almacén..." << endl;
+    // Armado desde el maestro (copias de exportación)
+    t0 = Reloj::now();
+    for (int i = 0; i < lotes; ++i) completos[i] = maestroLeerLote(m, i);
+    medicionAgregar(R, "registros/maestroLeerLote", cfg, lotes, nsDesde(t0));
     
-    string linea;
-    int nuevasFilas = 0, nuevasColumnas = 0;
+    t0 = Reloj::now();
+    for (int i = 0; i < lotes; ++i) compactos[i] = maestroLeerCompacto(m, i);
+    medicionAgregar(R, "registros/maestroLeerCompacto", cfg, lotes, nsDesde(t0));
     
-    // Leer metadatos del archivo
-    while (getline(archivo, linea)) {
-        if (linea[0] == '#') continue; // Ignorar comentarios
+    sumideroMedicion = (long long)peso + bajos + completos[lotes - 1].idLote + compactos[lotes - 1].nombreId;
+    maestroFree(m);
+}
+
+// Recorridos del arreglo DENSO en cada disposición (ns por celda): por filas, por
+// columnas, por bloques de 64 x 64 y los 4 vecinos de celdas al azar
+void medirDisposicion(int filas, int columnas, vector<Medicion>& R) {
+    ConfigMedicion cfg = {filas, columnas, 100, ALMACEN_DENSO, 0};
+    const char* const nombres[] = {"filas", "bloques"};
+    for (int disposicion : {DISPOSICION_FILAS, DISPOSICION_BLOQUES}) {
+        Almacen* A = crearAlmacen(filas, columnas, ALMACEN_DENSO, disposicion);
+        for (int idx = 0; idx < filas * columnas; ++idx) almacenCeldaAsignar(*A, idx, idx);
+        long long N = (long long)filas * columnas, suma = 0;
+        string sufijo = string("/") + nombres[disposicion];
         
-        // Buscar dimensiones
-        if (linea.find("DIMENSIONES=") == 0) {
-            size_t coma = linea.find(',');
-            if (coma != string::npos) {
-                nuevasFilas = stoi(linea.substr(12, coma - 12));
-                nuevasColumnas = stoi(linea.substr(coma + 1));
-            }
+        Reloj::time_point t0 = Reloj::now();
+        for (int f = 0; f < filas; ++f) {
+            for (int c = 0; c < columnas; ++c) suma += almacenSlotFC(*A, f, c);
         }
+        medicionAgregar(R, "recorrerFilas" + sufijo, cfg, N, nsDesde(t0));
         
-        // Si encontramos las dimensiones, crear nuevo almacén
-        if (nuevasFilas > 0 && nuevasColumnas > 0 && A == nullptr) {
-            filas = nuevasFilas;
-            columnas = nuevasColumnas;
-            A = crearAlmacen(filas, columnas);
-            cout << "Almacén recreado: " << filas << "x" << columnas << endl;
+        t0 = Reloj::now();
+        for (int c = 0; c < columnas; ++c) {
+            for (int f = 0; f < filas; ++f) suma += almacenSlotFC(*A, f, c);
         }
+        medicionAgregar(R, "recorrerColumnas" + sufijo, cfg, N, nsDesde(t0));
         
-        // Procesar líneas de datos (que no sean metadatos)
-        if (linea.find("=") == string::npos && linea[0] != '#' && !linea.empty()) {
-            // Parsear línea de datos: FILA,COLUMNA,ID,NOMBRE,PESO,CANTIDAD
-            size_t pos = 0;
-            string token;
-            vector<string> tokens;
-            
-            // Separar por comas
-            while ((pos = linea.find(',')) != string::npos) {
-                token = linea.substr(0, pos);
-                tokens.push_back(token);
-                linea.erase(0, pos + 1);
-            }
-            tokens.push_back(linea); // Último token
-            
-            if (tokens.size() >= 6) {
-                int f = stoi(tokens[0]);
-                int c = stoi(tokens[1]);
-                int id = stoi(tokens[2]);
-                string nombre = tokens[3];
-                float peso = stof(tokens[4]);
-                int cantidad = stoi(tokens[5]);
-                
-                // Crear lote y colocarlo
-                LoteProduccion* ptr = maestroCrear(maestro, id, nombre.c_str(), peso, cantidad);
-                if (colocar(A, filas, columnas, f, c, ptr)) {
-                    cout << "✓ Lote " << id << " importado en (" << f << "," << c << ")" << endl;
+        t0 = Reloj::now();
+        for (int bf = 0; bf < filas; bf += 64) {
+            for (int bc = 0; bc < columnas; bc += 64) {
+                for (int f = bf; f < min(bf + 64, filas); ++f) {
+                    for (int c = bc; c < min(bc + 64, columnas); ++c) suma += almacenSlotFC(*A, f, c);
                 }
             }
         }
+        medicionAgregar(R, "recorrerBloques" + sufijo, cfg, N, nsDesde(t0));
+        
+        const int consultas = 1000000;
+        uint64_t semilla = 0x2545F4914F6CDD1Dull;
+        t0 = Reloj::now();
+        for (int i = 0; i < consultas; ++i) {
+            int f = 1 + (int)(aleatorio(semilla) % (filas - 2)), c = 1 + (int)(aleatorio(semilla) % (columnas - 2));
+            suma += almacenSlotFC(*A, f - 1, c) + almacenSlotFC(*A, f + 1, c)
+                  + almacenSlotFC(*A, f, c - 1) + almacenSlotFC(*A, f, c + 1);
+        }
+        medicionAgregar(R, "vecinos" + sufijo, cfg, consultas, nsDesde(t0));
+        
+        sumideroMedicion = suma;
+        liberarAlmacen(A);
     }
-    
-    archivo.close();
-    cout << "✓ Importación completada. Lotes activos: " << maestro.size << endl;
-    return true;
 }
 
-// Crea un backup automático con timestamp
-bool crearBackup(LoteProduccion** A, const Maestro& maestro, int filas, int columnas) {
-    if (!A) {
-        cout << "✗ Error: No hay almacén para respaldar." << endl;
-        return false;
-    }
-    
-    // Generar nombre de archivo con timestamp simple
-    char nombreBackup[100];
-    strcpy(nombreBackup, "backup_almacen.txt");
-    
-    return exportarDatos(A, maestro, filas, columnas, nombreBackup);
+void medirPila(int capacidad, vector<Medicion>& R) {
+    ConfigMedicion cfg = {0, 0, 0, ALMACEN_AUTO, capacidad};
+    Pila p;
+    pilaInit(p, capacidad);
+    const int pushes = 10000000;
+    Reloj::time_point t0 = Reloj::now();
+    for (int i = 0; i < pushes; ++i) pilaPush(p, i, i & 1);
+    medicionAgregar(R, "pilaPush", cfg, pushes, nsDesde(t0));
+    pilaFree(p);
 }
 
-// Restaura desde un backup
-bool restaurarBackup(LoteProduccion**& A, Maestro& maestro, int& filas, int& columnas) {
-    // Limpiar almacén actual si existe
-    if (A) {
-        liberarAlmacen(A);
-        A = nullptr;
+// Escribe los resultados como JSON
+void escribirMediciones(const vector<Medicion>& R, SalidaLote& S) {
+    salidaTexto(S, "{\"version\":1,\"resultados\":[\n");
+    for (size_t i = 0; i < R.size(); ++i) {
+        const Medicion& m = R[i];
+        salidaTexto(S, "  {\"nombre\":\"");
+        salidaTexto(S, m.nombre);
+        salidaTexto(S, "\",\"filas\":");
+        salidaNumero(S, m.cfg.filas);
+        salidaTexto(S, ",\"columnas\":");
+        salidaNumero(S, m.cfg.columnas);
+        salidaTexto(S, ",\"ocupacion\":");
+        salidaNumero(S, m.cfg.ocupacion);
+        salidaTexto(S, ",\"modo\":\"");
+        salidaTexto(S, m.cfg.modo == ALMACEN_DENSO ? "denso" : m.cfg.modo == ALMACEN_DISPERSO ? "disperso" : "auto");
+        salidaTexto(S, "\",\"capacidad\":");
+        salidaNumero(S, m.cfg.capacidad);
+        salidaTexto(S, ",\"operaciones\":");
+        salidaNumero(S, m.operaciones);
+        salidaTexto(S, ",\"ns_por_op\":");
+        salidaDecimal(S, m.operaciones ? m.ns / m.operaciones : 0.0, 1);
+        salidaTexto(S, i + 1 < R.size() ? "},\n" : "}\n");
     }
-    maestroFree(maestro);
-    maestroInit(maestro);
-    
-    return importarDatos(A, maestro, filas, columnas, "backup_almacen.txt");
+    salidaTexto(S, "]}\n");
 }
 
-// Función para detectar y alertar sobre stock bajo
-void verificarStockBajo(LoteProduccion** A, int filas, int columnas, int umbralMinimo = 10) {
-    cout << "\n=== VERIFICACIÓN DE STOCK BAJO ===" << endl;
-    bool hayAlertas = false;
-    
-    for (int f = 0; f < filas; ++f) {
-        for (int c = 0; c < columnas; ++c) {
-            int idx = f * columnas + c;
-            if (A[idx] != nullptr && A[idx]->cantidadTotal <= umbralMinimo) {
-                if (!hayAlertas) {
-                    cout << "ALERTAS DE STOCK BAJO (≤" << umbralMinimo << " unidades):" << endl;
-                    hayAlertas = true;
-                }
-                cout << "  - Lote " << A[idx]->idLote 
-                     << " (" << A[idx]->nombreComponente << "): " 
-                     << A[idx]->cantidadTotal << " unidades restantes" << endl;
-            }
-        }
+// Ejecuta todas las mediciones y escribe el JSON en la salida estándar
+int ejecutarMediciones(bool completo) {
+#ifdef ALPHATECH_VERIFICAR
+    cerr << "⚠ Compilado con -DALPHATECH_VERIFICAR: mostrarEstadisticas incluye el verificador" << endl;
+#endif
+    vector<Medicion> R;
+    const ConfigMedicion configs[] = {
+        {100, 100, 10, ALMACEN_AUTO, 0}, {100, 100, 50, ALMACEN_AUTO, 0}, {100, 100, 90, ALMACEN_AUTO, 0},
+        {1000, 1000, 10, ALMACEN_AUTO, 0}, {1000, 1000, 50, ALMACEN_AUTO, 0}, {1000, 1000, 90, ALMACEN_AUTO, 0},
+        {1000, 1000, 50, ALMACEN_DISPERSO, 0},
+        {10000, 10000, 1, ALMACEN_DISPERSO, 0},
+        {10000, 10000, 1, ALMACEN_DENSO, 0},
+    };
+    for (const ConfigMedicion& cfg : configs) {
+        if (cfg.filas == 10000 && cfg.modo == ALMACEN_DENSO && !completo) continue;
+        cerr << "Midiendo " << cfg.filas << "x" << cfg.columnas << " al " << cfg.ocupacion << "%..." << endl;
+        medirAlmacen(cfg, R);
     }
+    medirRotacionMaestro(100000, R);
+    medirKernels(1000000, R);
+    medirRegistros(1000000, R);
+    medirDisposicion(1000, 1000, R);
+    medirDisposicion(4000, 4000, R);
+    medirPila(10, R);
+    medirPila(1000, R);
+    medirPila(1000000, R);
     
-    if (!hayAlertas) {
-        cout << "✓ No hay alertas de stock bajo." << endl;
-    }
+    SalidaLote S;
+    salidaInit(S, stdout);
+    escribirMediciones(R, S);
+    return salidaFree(S) ? 0 : 1;
 }
 
 /*======================================================================================
-FUNCIONES AUXILIARES DE UTILIDAD
+MODO DE ESTRÉS CONCURRENTE: alphatech --estres [hilos] [operaciones]
 ======================================================================================
-Estas funciones proporcionan utilidades adicionales para el manejo del sistema:
-- Limpiar pantalla para mejor presentación
-- Pausar ejecución para lectura
-- Mostrar ayuda del sistema
+Ejercita el acceso concurrente con varios hilos terminales (colocar, mover, remover,
+buscar, inspeccionar, leer filas) y un hilo lector que consulta filas, totales y pila
+sin bloqueo, sobre un almacén DENSO y otro DISPERSO. Cada almacén pasa por dos fases:
+mixta y solo movimientos/lecturas; la segunda no toma el maestro en modo exclusivo, así
+las franjas son lo único que ordena a los hilos y TSan detecta cualquier acceso a una
+fila sin su franja aunque la máquina tenga pocos núcleos. Al terminar recalcula todo con un
+recorrido completo y lo compara con los agregados, el maestro y los contadores de los
+hilos. Pensado para correr compilado con -fsanitize=thread (TSan):
+    g++ -std=c++17 -O1 -g -fsanitize=thread -pthread main.cpp -o alphatech_tsan
+    ./alphatech_tsan --estres 8 20000
+No toca el estado persistente (la bitácora de prueba es un archivo temporal propio).
+RETORNA: 0 si todo es consistente, 1 si no.
 ======================================================================================*/
+const int ESTRES_FILAS = 48;             // Pocas filas: muchas colisiones de franjas
+const int ESTRES_COLUMNAS = 200;          // Varias palabras por fila (filas dispersas que crecen)
+const char* const ARCHIVO_ESTRES_BITACORA = "estres_tmp.log";
+const char* const ARCHIVO_ESTRES_NOMBRES = "estres_tmp.log.nombres";
 
-// Función para pausar y esperar input del usuario
-void pausar() {
-    cout << "\nPresione ENTER para continuar...";
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-    cin.get();
+// Resultado de un hilo terminal
+struct ContadoresEstres {
+    long long colocados;
+    long long removidos;
+    long long movidos;
+    long long errores;     // Invariantes violados vistos desde el hilo
+};
+
+void terminalEstres(AlmacenConcurrente& C, int hilo, int hilos, int operaciones, bool soloMovimientos,
+                    ContadoresEstres& R) {
+    uint64_t semilla = 0x9E3779B97F4A7C15ull * (uint64_t)(hilo + 1) + soloMovimientos;
+    int maxId = hilos * operaciones;
+    vector<int> columnas, ids;
+    vector<int> propios;  // IDs colocados por este hilo (candidatos a remover)
+    R = ContadoresEstres{0, 0, 0, 0};
+    for (int k = 0; k < operaciones; ++k) {
+        int r = (int)(aleatorio(semilla) % 100);
+        if (soloMovimientos) r = 55 + r % 45;
+        int f = (int)(aleatorio(semilla) % ESTRES_FILAS), c = (int)(aleatorio(semilla) % ESTRES_COLUMNAS);
+        int id = 1 + (int)(aleatorio(semilla) % maxId);
+        if (r < 35) {
+            // IDs propios del hilo: hilo*operaciones + k + 1 (nunca chocan entre hilos)
+            char nombre[NOMBRE_MAX];
+            snprintf(nombre, sizeof(nombre), "EST-%02d", (int)(aleatorio(semilla) % 16));
+            if (concColocar(C, f, c, hilo * operaciones + k + 1, nombre, 0.25f + (float)(k % 9), 1 + k % 50)) {
+                propios.push_back(hilo * operaciones + k + 1);
+                R.colocados++;
+            }
+        } else if (r < 55) {
+            // Casi siempre un lote propio; a veces cualquiera (compite con otros hilos)
+            if (!propios.empty() && r < 50) {
+                size_t i = aleatorio(semilla) % propios.size();
+                id = propios[i];
+                propios[i] = propios.back();
+                propios.pop_back();
+            }
+            if (concRemover(C, id)) R.removidos++;
+        } else if (r < 80) {
+            int fd = (aleatorio(semilla) & 1) ? f : (int)(aleatorio(semilla) % ESTRES_FILAS);
+            if (concMover(C, f, c, fd, (int)(aleatorio(semilla) % ESTRES_COLUMNAS))) R.movidos++;
+        } else if (r < 88) {
+            int fila, columna;
+            if (concBuscarID(C, id, fila, columna) && !almacenDentro(*C.A, fila, columna)) R.errores++;
+        } else if (r < 94) {
+            concInspeccionar(C, id, (int)(aleatorio(semilla) & 1));
+        } else {
+            int ocupadas;
+            long long unidades;
+            double peso;
+            concFila(C, f, columnas, ids, ocupadas, unidades, peso);
+            if (ocupadas != (int)columnas.size()) R.errores++;
+        }
+    }
 }
 
-// Mostrar ayuda del sistema
-void mostrarAyuda() {
-    cout << "\n=== GUÍA RÁPIDA DEL SISTEMA ALPHATECH ===" << endl;
-    cout << "\nFUNCIONES PRINCIPALES:" << endl;
-    cout << "• Crear almacén: Define las dimensiones de tu almacén (máx 20x20)" << endl;
-    cout << "• Colocar lotes: Asigna componentes a posiciones específicas" << endl;
-    cout << "• Inspecciones: Lleva control de calidad con historial" << endl;
-    cout << "• Búsquedas: Localiza componentes por nombre o ID" << endl;
-    cout << "• Reportes: Consulta estadísticas y estados del almacén" << endl;
+// Lector sin bloqueo: totales, filas y pila mientras las terminales trabajan
+void lectorEstres(const AlmacenConcurrente& C, const atomic<bool>& fin, long long& lecturas, long long& errores) {
+    int area = C.A->filas * C.A->columnas;
+    vector<int> ids, resultados, columnas;
+    lecturas = errores = 0;
+    for (int f = 0; !fin.load(memory_order_acquire); f = (f + 1) % C.A->filas) {
+        int ocupadas;
+        long long unidades;
+        double peso;
+        // Una fila leída sin candado es una instantánea coherente: columnas crecientes,
+        // IDs vivos y tantos lotes como su subtotal
+        concFila(C, f, columnas, ids, ocupadas, unidades, peso);
+        if (ocupadas != (int)columnas.size()) errores++;
+        for (size_t i = 0; i < columnas.size(); ++i) {
+            if (ids[i] <= 0 || (i > 0 && columnas[i] <= columnas[i - 1])) errores++;
+        }
+        concEstadisticas(C, ocupadas, unidades, peso);
+        // Los totales se publican después de soltar las franjas: pueden ir un poco
+        // atrasados, pero nunca fuera de rango
+        if (ocupadas < -FRANJAS_ALMACEN || ocupadas > area + FRANJAS_ALMACEN) errores++;
+        pilaCopiar(*C.pila, ids, resultados);
+        if ((int)ids.size() > C.pila->capacidad) errores++;
+        lecturas++;
+        this_thread::yield();
+    }
+}
+
+// Recorrido completo después de unir los hilos: celdas, maestro, agregados y contadores
+bool verificarEstres(const AlmacenConcurrente& C, long long colocados, long long removidos) {
+    const Almacen& A = *C.A;
+    const Maestro& maestro = *C.maestro;
+    bool ok = true;
+    vector<int> celdas;
+    almacenOcupadas(A, 0, A.filas, celdas);
     
-    cout << "\nALERTAS AUTOMÁTICAS:" << endl;
-    cout << "• Almacén >75% ocupado: Advertencia de capacidad" << endl;
-    cout << "• Almacén >90% ocupado: Alerta crítica" << endl;
-    cout << "• Stock bajo: Componentes con ≤10 unidades" << endl;
-    cout << "• Alta tasa rechazo: >20% inspecciones rechazadas" << endl;
+    long long unidades = 0;
+    double peso = 0.0;
+    vector<int> lotesFila(A.filas, 0);
+    vector<long long> unidadesFila(A.filas, 0);
+    vector<int> teselas(A.bandas * A.palabrasFila, 0);
+    for (int idx : celdas) {
+        teselas[(idx / A.columnas / ALTO_TESELA) * A.palabrasFila + ((idx % A.columnas) >> 6)]++;
+        int slot = almacenSlot(A, idx);
+        ok = ok && slot != -1 && maestroUsado(maestro, slot) && maestroCelda(maestro, slot) == idx;
+        if (slot == -1) continue;
+        unidades += maestroCantidad(maestro, slot);
+        peso += (double)maestroPeso(maestro, slot) * maestroCantidad(maestro, slot);
+        lotesFila[idx / A.columnas]++;
+        unidadesFila[idx / A.columnas] += maestroCantidad(maestro, slot);
+    }
+    for (int f = 0; f < A.filas; ++f) {
+        ok = ok && lotesFila[f] == A.ocupadasFila[f] && unidadesFila[f] == A.unidadesFila[f];
+    }
+    ok = ok && (int)celdas.size() == A.ocupadas && unidades == A.unidades;
+    ok = ok && equal(teselas.begin(), teselas.end(), A.teselas);
+    ok = ok && fabs(peso - A.peso) <= 1e-6 * (1.0 + fabs(peso));
     
-    cout << "\nGESTIÓN DE DATOS:" << endl;
-    cout << "• Backup automático: Guarda estado completo" << endl;
-    cout << "• Exportar/Importar: Intercambio de datos" << endl;
-    cout << "• Restauración: Recupera desde backups" << endl;
+    // Ningún lote quedó en el maestro sin celda, y el balance de los hilos cuadra
+    ok = ok && maestro.size == A.ocupadas && colocados - removidos == A.ocupadas;
     
-    cout << "\nCONSEJOS DE USO:" << endl;
-    cout << "• IDs únicos: Cada lote debe tener un ID diferente" << endl;
-    cout << "• Posiciones: Coordenadas empiezan en (0,0)" << endl;
-    cout << "• Historial: Máximo 10 inspecciones en memoria" << endl;
-    cout << "• Validación: El sistema verifica todas las entradas" << endl;
+    // Lo publicado para los lectores coincide con los agregados finales
+    int ocupadasPub;
+    long long unidadesPub;
+    double pesoPub;
+    concEstadisticas(C, ocupadasPub, unidadesPub, pesoPub);
+    ok = ok && ocupadasPub == A.ocupadas && unidadesPub == A.unidades && pesoPub == A.peso;
+    return ok;
+}
+
+int ejecutarEstres(int hilos, int operaciones) {
+    bool todoOk = true;
+    const int modos[] = {ALMACEN_DENSO, ALMACEN_DISPERSO};
+    for (int modo : modos) {
+        Almacen* A = crearAlmacen(ESTRES_FILAS, ESTRES_COLUMNAS, modo);
+        Maestro maestro;
+        maestroInit(maestro);
+        Pila pila;
+        pilaInit(pila);
+        BitacoraInspecciones bitacora;
+        remove(ARCHIVO_ESTRES_BITACORA);
+        remove(ARCHIVO_ESTRES_NOMBRES);
+        bool conBitacora = false;
+#ifdef ALPHATECH_MMAP
+        conBitacora = bitacoraAbrir(bitacora, ARCHIVO_ESTRES_BITACORA);
+#endif
+        AlmacenConcurrente C;
+        concInit(C, A, maestro, pila, conBitacora ? &bitacora : nullptr);
+        
+        // Terminales (dos fases) y lector en paralelo
+        vector<ContadoresEstres> R(hilos);
+        ContadoresEstres total = {0, 0, 0, 0};
+        atomic<bool> fin(false);
+        long long lecturas = 0, erroresLector = 0;
+        Reloj::time_point t0 = Reloj::now();
+        thread lector(lectorEstres, cref(C), cref(fin), ref(lecturas), ref(erroresLector));
+        for (int fase = 0; fase < 2; ++fase) {
+            vector<thread> terminales;
+            for (int h = 0; h < hilos; ++h) {
+                terminales.emplace_back(terminalEstres, ref(C), h, hilos, operaciones, fase == 1, ref(R[h]));
+            }
+            for (thread& t : terminales) t.join();
+            for (const ContadoresEstres& r : R) {
+                total.colocados += r.colocados;
+                total.removidos += r.removidos;
+                total.movidos += r.movidos;
+                total.errores += r.errores;
+            }
+        }
+        fin.store(true, memory_order_release);
+        lector.join();
+        double segundos = nsDesde(t0) / 1e9;
+        
+        // Balance y verificación completa
+        total.errores += erroresLector;
+        bool ok = total.errores == 0 && verificarEstres(C, total.colocados, total.removidos);
+        todoOk = todoOk && ok;
+        
+        cout << (modo == ALMACEN_DENSO ? "DENSO   " : "DISPERSO") << ": " << hilos << " hilos x 2 x "
+             << operaciones << " operaciones en " << fixed << setprecision(2) << segundos << " s ("
+             << setprecision(0) << (2 * hilos * (double)operaciones / segundos) << " ops/s); "
+             << total.colocados << " colocados, " << total.movidos << " movidos, "
+             << total.removidos << " removidos, " << lecturas << " lecturas sin bloqueo -> "
+             << (ok ? "CONSISTENTE" : "INCONSISTENTE") << endl;
+        
+        concFree(C);
+        if (conBitacora) bitacoraCerrar(bitacora);
+        remove(ARCHIVO_ESTRES_BITACORA);
+        remove(ARCHIVO_ESTRES_NOMBRES);
+        pilaFree(pila);
+        maestroFree(maestro);
+        liberarAlmacen(A);
+    }
+    return todoOk ? 0 : 1;
+}
+
+// Limpieza de memoria (el diario y la bitácora confirman lo pendiente al cerrarse)
+void cerrarSistema(Almacen*& A, Maestro& maestro, Pila& pila, Diario& D, BitacoraInspecciones& B) {
+    diarioFree(D);
+    bitacoraCerrar(B);
+    if (A) liberarAlmacen(A);
+    A = nullptr;
+    maestroFree(maestro);
+    pilaFree(pila);
+    
+    cout << "✓ Sistema cerrado correctamente. ¡Hasta luego!" << endl;
 }
 
 /*======================================================================================
 FUNCIÓN PRINCIPAL CON MENÚ INTERACTIVO
 ======================================================================================*/
-int main() {
+int main(int argc, char* argv[]) {
+    // Modo por lotes: la salida estándar queda solo para las respuestas
+    bool modoLote = (argc >= 2 && strcmp(argv[1], "--batch") == 0);
+    
+    // Modo reporte: el reporte completo va directo al descriptor de la salida estándar
+    bool modoReporte = (argc >= 2 && strcmp(argv[1], "--reporte") == 0);
+    FormatoReporte formatoReporte = REPORTE_TEXTO;
+    if (modoReporte && (argc > 3 || (argc == 3 && !leerFormatoReporte(argv[2], formatoReporte)))) {
+        cerr << "Uso: alphatech --reporte [texto|tabla|csv|json]" << endl;
+        return 2;
+    }
+    
+    streambuf* salidaOriginal = cout.rdbuf();
+    if (modoLote || modoReporte) cout.rdbuf(cerr.rdbuf());
+    
+    // Modo de estrés concurrente: tampoco toca el estado persistente
+    if (argc >= 2 && strcmp(argv[1], "--estres") == 0) {
+        int hilos = (argc >= 3) ? atoi(argv[2]) : 8;
+        int operaciones = (argc >= 4) ? atoi(argv[3]) : 20000;
+        if (hilos < 1 || hilos > 256 || operaciones < 1 || operaciones > 10000000) {
+            cerr << "Uso: alphatech --estres [hilos 1-256] [operaciones por hilo]" << endl;
+            return 2;
+        }
+        return ejecutarEstres(hilos, operaciones);
+    }
+    
+    // Modo de medición: no carga ni modifica el estado persistente
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        cout.rdbuf(cerr.rdbuf());
+        int codigo = ejecutarMediciones(argc >= 3 && strcmp(argv[2], "completo") == 0);
+        cout.rdbuf(salidaOriginal);
+        return codigo;
+    }
+    
     cout << "=== SISTEMA DE GESTIÓN DE ALMACÉN ALPHATECH ===" << endl;
     cout << "Inicializando sistemas..." << endl;
 
     // Variables del almacén
-    int filas = 0, columnas = 0;
-    LoteProduccion** almacen = nullptr;
+    Almacen* almacen = nullptr;
 
     // Inicialización de estructuras
     Maestro maestro; 
     maestroInit(maestro);
     Pila pila; 
     pilaInit(pila);
+    
+    // Recuperar el último estado confirmado (snapshot + diario de operaciones)
+    Diario diario;
+    diarioInit(diario, modoLote ? DIARIO_GRUPO_LOTE : DIARIO_GRUPO);
+    if (!restaurarBackup(almacen, maestro, diario)) {
+        // Seguir sin diario perdería en silencio cada operación confirmada
+        cout << "✗ Error: No se pudo recuperar el estado ni abrir el diario de operaciones." << endl;
+        cout << "  Revise " << ARCHIVO_BACKUP << " y " << ARCHIVO_DIARIO
+             << " (o retírelos para empezar de cero) y vuelva a iniciar." << endl;
+        diarioFree(diario);
+        if (almacen) liberarAlmacen(almacen);
+        maestroFree(maestro);
+        pilaFree(pila);
+        cout.rdbuf(salidaOriginal);
+        return 2;
+    }
+    
+    // Bitácora de inspecciones; la pila se llena con sus últimos registros
+    BitacoraInspecciones bitacora;
+    if (bitacoraAbrir(bitacora, ARCHIVO_INSPECCIONES)) {
+        size_t desde = bitacora.n - min(bitacora.n, (size_t)pila.capacidad);
+        for (size_t i = desde; i < bitacora.n; ++i) {
+            pilaPush(pila, bitacoraRegistro(bitacora, i)->idLote, bitacoraRegistro(bitacora, i)->resultado);
+        }
+    } else {
+        cout << "⚠ Las inspecciones se registrarán solo en memoria." << endl;
+    }
+    
+    if (modoLote) {
+        int codigo = 2;
+        const char* nombreArchivo = argc >= 3 ? argv[2] : "-";
+        if (strcmp(nombreArchivo, "-") == 0) {
+            codigo = ejecutarLote(cin, almacen, maestro, pila, diario, bitacora);
+        } else {
+            ifstream archivo(nombreArchivo, ios::binary);
+            if (archivo.is_open()) codigo = ejecutarLote(archivo, almacen, maestro, pila, diario, bitacora);
+            else cout << "✗ Error: No se pudo abrir el archivo " << nombreArchivo << endl;
+        }
+        cerrarSistema(almacen, maestro, pila, diario, bitacora);
+        cout.rdbuf(salidaOriginal);
+        return codigo;
+    }
+    
+    if (modoReporte) {
+        int codigo = 1;
+        if (!almacen) {
+            cout << "✗ Error: No hay almacén inicializado." << endl;
+        } else {
+            SalidaLote S;
+#ifdef ALPHATECH_MMAP
+            salidaInitDescriptor(S, STDOUT_FILENO);
+#else
+            salidaInit(S, stdout);
+#endif
+            reporteCompleto(*almacen, maestro, S, formatoReporte);
+            codigo = salidaFree(S) ? 0 : 1;
+        }
+        cerrarSistema(almacen, maestro, pila, diario, bitacora);
+        cout.rdbuf(salidaOriginal);
+        return codigo;
+    }
 
     int opc;
     do {
+        // Confirmar en disco las operaciones pendientes antes de esperar al usuario
+        diarioMantenimiento(almacen, maestro, diario);
+        bitacoraSincronizar(bitacora);
+        
         cout << "\n--- AlphaTech: Control de Lotes Dinámico ---" << endl;
         cout << "1. Inicializar almacén" << endl;
         cout << "2. Colocar lote" << endl;
@@ -762,28 +6871,63 @@ int main() {
         cout << "4. Deshacer (Pop de Pila)" << endl;
         cout << "5. Reporte por fila" << endl;
         cout << "6. Buscar por componente" << endl;
-        cout << "7. Salir" << endl;
+        cout << "7. Métricas de rendimiento" << endl;
+        cout << "8. Salir" << endl;
         cout << "Opción: ";
         
-        opc = validarEntero("", 1, 7);
+        opc = validarEntero("", 1, 8);
+        
+        // Sin diario no se aceptan cambios: se perderían al reiniciar
+        if (diario.error && (opc == 1 || opc == 2)) {
+            cout << "✗ Error: El diario de operaciones no está disponible; no se aceptan cambios."
+                 << " Revise el disco y reinicie el sistema." << endl;
+            continue;
+        }
 
         switch(opc) {
             case 1: {
                 // Inicializar almacén
                 if (almacen) {
+                    if (confirmarAccion("¿Desea redimensionar el almacén conservando los lotes?")) {
+                        cout << "Nuevo número de filas (1-" << MAX_DIMENSION << "): ";
+                        int nf = validarEntero("", 1, MAX_DIMENSION);
+                        cout << "Nuevo número de columnas (1-" << MAX_DIMENSION << "): ";
+                        int nc = validarEntero("", 1, MAX_DIMENSION);
+                        
+                        vector<int> fuera;
+                        redimensionarAlmacen(almacen, maestro, nf, nc, fuera);
+                        diarioAnotar(diario, DIARIO_REDIMENSIONAR, nf, nc);
+                        cout << "✓ Almacén redimensionado a " << nf << "x" << nc << "." << endl;
+                        if (!fuera.empty()) {
+                            cout << "⚠ " << fuera.size() << " lote(s) quedaron fuera de los nuevos límites y sin posición:";
+                            for (int id : fuera) cout << " " << id;
+                            cout << endl;
+                            cout << "  Puede volver a colocarlos con la opción 2 indicando su ID." << endl;
+                        }
+                        break;
+                    }
                     if (confirmarAccion("¿Desea reinicializar el almacén? Se perderán todos los datos")) {
                         liberarAlmacen(almacen);
                         almacen = nullptr;
+                        maestroDesubicar(maestro);  // Los lotes quedan sin posición
+                        if (maestro.size > 0) {
+                            cout << "⚠ " << maestro.size << " lote(s) quedaron registrados sin posición;"
+                                 << " puede volver a colocarlos con la opción 2 indicando su ID." << endl;
+                        }
                     } else {
                         break;
                     }
                 }
                 
-                filas = validarEntero("Ingrese el número de filas (1-20): ", 1, 20);
-                columnas = validarEntero("Ingrese el número de columnas (1-20): ", 1, 20);
+                cout << "Ingrese el número de filas (1-" << MAX_DIMENSION << "): ";
+                int filas = validarEntero("", 1, MAX_DIMENSION);
+                cout << "Ingrese el número de columnas (1-" << MAX_DIMENSION << "): ";
+                int columnas = validarEntero("", 1, MAX_DIMENSION);
                 
                 almacen = crearAlmacen(filas, columnas);
-                cout << "✓ Almacén " << filas << "x" << columnas << " creado exitosamente." << endl;
+                diarioAnotar(diario, DIARIO_ALMACEN, filas, columnas);
+                cout << "✓ Almacén " << filas << "x" << columnas << " creado exitosamente"
+                     << (almacen->modo == ALMACEN_DISPERSO ? " (modo disperso)." : ".") << endl;
                 break;
             }
             
@@ -794,18 +6938,56 @@ int main() {
                     break;
                 }
                 
+                // Recepción de un camión: varios lotes en bloque
+                if (confirmarAccion("¿Recibir varios lotes a la vez (camión)?")) {
+                    recibirCamion(*almacen, maestro, diario);
+                    break;
+                }
+                
                 int f, c, id, cant;
                 float peso;
                 char nombre[50];
                 
-                cout << "Ingrese la fila (0-" << (filas-1) << "): ";
-                f = validarEntero("", 0, filas-1);
-                cout << "Ingrese la columna (0-" << (columnas-1) << "): ";
-                c = validarEntero("", 0, columnas-1);
+                // Ubicación automática: primera celda libre según el mapa de ocupación
+                if (confirmarAccion("¿Ubicación automática (primera celda libre)?")) {
+                    if (!almacenPrimeraLibre(*almacen, f, c)) {
+                        cout << "✗ Error: El almacén está lleno." << endl;
+                        break;
+                    }
+                    cout << "Posición asignada: (" << f << ", " << c << ")" << endl;
+                } else {
+                    cout << "Ingrese la fila (0-" << (almacen->filas-1) << "): ";
+                    f = validarEntero("", 0, almacen->filas-1);
+                    cout << "Ingrese la columna (0-" << (almacen->columnas-1) << "): ";
+                    c = validarEntero("", 0, almacen->columnas-1);
+                    
+                    // Si está ocupada, sugerir la celda libre más cercana
+                    int fl, cl;
+                    if (almacenOcupadaFC(*almacen, f, c) && almacenLibreMasCercana(*almacen, f, c, fl, cl)) {
+                        cout << "La posición está ocupada. Celda libre más cercana: (" << fl << ", " << cl << ")" << endl;
+                        if (!confirmarAccion("¿Usar esa posición?")) break;
+                        f = fl;
+                        c = cl;
+                    }
+                }
                 id = validarEntero("Ingrese el ID del lote (positivo): ", 1, 99999);
                 
-                // Verificar si ya existe el ID
-                if (maestroBuscarID(maestro, id) != -1) {
+                // Verificar si ya existe el ID; si quedó sin posición se puede volver a colocar
+                int existente = maestroBuscarID(maestro, id);
+                if (existente != -1 && maestroCelda(maestro, existente) == -1) {
+                    cout << "El lote " << id << " (" << maestroNombre(maestro, existente)
+                         << ") está registrado sin posición." << endl;
+                    if (confirmarAccion("¿Colocarlo en esta posición?")) {
+                        if (ubicarLote(*almacen, maestro, id, f, c) != -1) {
+                            diarioAnotar(diario, DIARIO_COLOCAR, id, f, c, 0, &maestro, existente);
+                            cout << "✓ Lote colocado exitosamente en posición (" << f << ", " << c << ")" << endl;
+                        } else {
+                            cout << "✗ Error: No se pudo colocar (posición ocupada)" << endl;
+                        }
+                    }
+                    break;
+                }
+                if (existente != -1) {
                     cout << "✗ Error: Ya existe un lote con ID " << id << endl;
                     break;
                 }
@@ -815,10 +6997,12 @@ int main() {
                 peso = validarFloat("Ingrese el peso unitario (kg): ", 0.001f, 1000.0f);
                 cant = validarEntero("Ingrese la cantidad total: ", 1, 100000);
 
-                LoteProduccion* ptr = maestroCrear(maestro, id, nombre, peso, cant);
-                if (colocar(almacen, filas, columnas, f, c, ptr)) {
+                int slot = maestroCrear(maestro, id, nombre, peso, cant);
+                if (colocar(*almacen, maestro, f, c, slot)) {
+                    diarioAnotar(diario, DIARIO_COLOCAR, id, f, c, 0, &maestro, slot);
                     cout << "✓ Lote colocado exitosamente en posición (" << f << ", " << c << ")" << endl;
                 } else {
+                    maestroEliminar(maestro, id);  // No dejar lotes huérfanos en el maestro
                     cout << "✗ Error: No se pudo colocar (posición ocupada)" << endl;
                 }
                 break;
@@ -828,16 +7012,25 @@ int main() {
                 // Control de calidad (Inspección)
                 int id = validarEntero("Ingrese el ID del lote a inspeccionar: ", 1, 99999);
                 
-                if (maestroBuscarID(maestro, id) == -1) {
+                int slot = maestroBuscarID(maestro, id);
+                if (slot == -1) {
                     cout << "✗ Error: No existe un lote con ID " << id << endl;
                     break;
                 }
                 
                 int resultado = validarEntero("Ingrese el resultado (1=Aprobado, 0=Rechazado): ", 0, 1);
                 
+                const char* componente = maestroNombre(maestro, slot);
+                // Primero la bitácora: la pila no debe tener una inspección que la bitácora no tiene
+                if (bitacora.datos && !bitacoraRegistrar(bitacora, id, resultado, componente)) {
+                    cout << "✗ Error: La inspección no se registró." << endl;
+                    break;
+                }
                 pilaPush(pila, id, resultado);
                 cout << "✓ Inspección registrada: Lote " << id << " - " 
                      << (resultado ? "APROBADO" : "RECHAZADO") << endl;
+                mostrarTasa("  Lote: ", bitacoraSerieLote(bitacora, id));
+                mostrarTasa("  Componente: ", bitacoraSerieComponente(bitacora, componente));
                 break;
             }
             
@@ -845,6 +7038,7 @@ int main() {
                 // Deshacer (Pop de Pila)
                 int id, resultado;
                 if (pilaPop(pila, id, resultado)) {
+                    bitacoraDeshacer(bitacora);
                     cout << "✓ Inspección deshecha: Lote " << id << " - " 
                          << (resultado ? "APROBADO" : "RECHAZADO") << endl;
                 } else {
@@ -860,9 +7054,9 @@ int main() {
                     break;
                 }
                 
-                cout << "Fila a consultar (0-" << (filas-1) << "): ";
-                int f = validarEntero("", 0, filas-1);
-                reporteFila(almacen, filas, columnas, f);
+                cout << "Fila a consultar (0-" << (almacen->filas-1) << "): ";
+                int f = validarEntero("", 0, almacen->filas-1);
+                reporteFila(*almacen, maestro, f);
                 break;
             }
             
@@ -875,32 +7069,47 @@ int main() {
                 
                 char nombre[50];
                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                validarString("Ingrese el nombre del componente: ", nombre, 50);
+                validarString("Ingrese el nombre del componente (termine en * para buscar por prefijo): ", nombre, 50);
                 
-                if (!buscarPorNombre(almacen, filas, columnas, nombre)) {
+                // "RES-*" busca todos los componentes que empiezan con "RES-"
+                size_t largo = strlen(nombre);
+                bool encontrado;
+                if (nombre[largo - 1] == '*') {
+                    nombre[largo - 1] = '\0';
+                    encontrado = buscarPorPrefijo(*almacen, maestro, nombre);
+                } else {
+                    encontrado = buscarPorNombre(*almacen, maestro, nombre);
+                }
+                if (!encontrado) {
                     cout << "✗ No se encontraron componentes con ese nombre." << endl;
                 }
                 break;
             }
             
             case 7: {
+                // Métricas de rendimiento (contadores y latencias)
+                cout << "\n=== MÉTRICAS DE RENDIMIENTO ===" << endl;
+                volcarMetricas(cout);
+                if (confirmarAccion("¿Guardar las métricas en metricas_almacen.txt?")) {
+                    if (volcarMetricas(ARCHIVO_METRICAS)) cout << "✓ Métricas guardadas en " << ARCHIVO_METRICAS << endl;
+                }
+                break;
+            }
+            
+            case 8: {
                 // Salir
                 cout << "Cerrando sistema y liberando memoria..." << endl;
                 break;
             }
             
             default: {
-                cout << "✗ Opción inválida. Seleccione entre 1-7." << endl;
+                cout << "✗ Opción inválida. Seleccione entre 1-8." << endl;
                 break;
             }
         }
         
-    } while(opc != 7);
+    } while(opc != 8);
 
-    // Limpieza de memoria
-    if (almacen) liberarAlmacen(almacen);
-    maestroFree(maestro);
-    
-    cout << "✓ Sistema cerrado correctamente. ¡Hasta luego!" << endl;
+    cerrarSistema(almacen, maestro, pila, diario, bitacora);
     return 0;
 }